@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "config.hpp"
 #include "extern.hpp"
 #include "memory.hpp"
 #include "spinlock.hpp"
@@ -41,7 +42,27 @@ class Buddy
                 };
         };
 
+        // Per-CPU lists of order-0 and order-1 blocks
+        enum {
+            HOT_ORD     = 2,
+            HOT_MAX     = 32
+        };
+
+        // Per-CPU pools of order-0 blocks zeroed while idle, under hot_lock
+        enum {
+            ZERO_MAX    = 64,
+            ZERO_BATCH  = 8
+        };
+
         Spinlock        lock;
+        Spinlock        hot_lock[NUM_CPU];
+        Block *         hot[NUM_CPU][HOT_ORD];
+        unsigned        hot_cnt[NUM_CPU][HOT_ORD];
+        unsigned        hot_high;
+        Block *         zero[NUM_CPU];
+        unsigned        zero_cnt[NUM_CPU];
+        unsigned        zero_total;
+        unsigned        zero_limit;
         signed long     max_idx;
         signed long     min_idx;
         mword           base;
@@ -85,6 +106,13 @@ class Buddy
             return phys + reinterpret_cast<mword>(&OFFSET);
         }
 
+        Block *take (unsigned short);
+        Block *alloc_block (unsigned short);
+
+        void free_block (Block *);
+
+        unsigned long reclaim();
+
     public:
         enum Fill
         {
@@ -102,6 +130,8 @@ class Buddy
 
         void free (mword addr);
 
+        void prezero();
+
         ALWAYS_INLINE
         static inline void *phys_to_ptr (Paddr phys)
         {
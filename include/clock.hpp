@@ -0,0 +1,62 @@
+/*
+ * User-Readable Clock Page
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "barrier.hpp"
+#include "config.hpp"
+#include "extern.hpp"
+#include "spinlock.hpp"
+
+/*
+ * Readers retry while seq is odd or changed across the read. Time is
+ * ns = ns_base + ((tsc + tsc_adj[cpu] - tsc_base) * mult >> shift)
+ * where the product must be computed with 96-bit precision and cpu is
+ * the TSC_AUX value returned by RDTSCP.
+ */
+class Clock
+{
+    private:
+        uint32  seq;                    // 0x0
+        uint32  shift;                  // 0x4
+        uint32  mult;                   // 0x8
+        uint32  freq_tsc;               // 0xc
+        uint64  tsc_base;               // 0x10
+        uint64  ns_base;                // 0x18
+        uint64  tsc_adj[NUM_CPU];       // 0x20
+
+        static Spinlock lock;
+        static uint64   ref;
+        static mword    ack;
+
+        ALWAYS_INLINE
+        static inline Clock *clock()
+        {
+            // Hide the symbol from the compiler's object-size tracking
+            Clock *c = reinterpret_cast<Clock *>(&PAGE_C);
+            asm ("" : "+r" (c));
+            return c;
+        }
+
+        ALWAYS_INLINE
+        inline void write_begin() { seq++; barrier(); }
+
+        ALWAYS_INLINE
+        inline void write_end() { barrier(); seq++; }
+
+    public:
+        static void init();
+        static void sync();
+};
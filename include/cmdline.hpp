@@ -43,6 +43,7 @@ class Cmdline
         static bool spinner;
         static bool vtlb;
         static bool nodl;
+        static bool nomwait;
         static bool nopcid;
         static bool novga;
         static bool novpid;
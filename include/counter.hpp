@@ -31,6 +31,7 @@ class Counter
         static unsigned lvt[NUM_LVT]    CPULOCAL;
         static unsigned gsi[NUM_GSI]    CPULOCAL;
         static unsigned exc[NUM_EXC]    CPULOCAL;
+        static unsigned sched_link[NUM_LNK] CPULOCAL;
         static unsigned vmi[NUM_VMI]    CPULOCAL;
         static unsigned vtlb_gpf        CPULOCAL;
         static unsigned vtlb_hpf        CPULOCAL;
@@ -38,7 +39,26 @@ class Counter
         static unsigned vtlb_flush      CPULOCAL;
         static unsigned schedule        CPULOCAL;
         static unsigned helping         CPULOCAL;
+        static unsigned help_yield      CPULOCAL;
+        static unsigned ipc_call        CPULOCAL;
+        static unsigned ipc_reply       CPULOCAL;
+        static unsigned ipc_fwd         CPULOCAL;
+        static unsigned ipc_xcpu        CPULOCAL;
+        static unsigned timer_set       CPULOCAL;
+        static unsigned rrq_coalesced   CPULOCAL;
+        static unsigned rrq_polled      CPULOCAL;
+        static unsigned rrq_wakeup      CPULOCAL;
+        static unsigned zero_hit        CPULOCAL;
+        static unsigned zero_miss       CPULOCAL;
         static uint64   cycles_idle     CPULOCAL;
+        static uint64   cycles_cst[NUM_CST] CPULOCAL;
+        static uint64   cycles_link[NUM_LNK] CPULOCAL;
+        static uint64   cycles_sched    CPULOCAL;
+        static uint64   cycles_call     CPULOCAL;
+        static uint64   cycles_reply    CPULOCAL;
+        static uint64   cycles_xcpu     CPULOCAL;
+        static uint64   cycles_wake     CPULOCAL;
+        static uint64   cycles_zero     CPULOCAL;
 
         static void dump();
 
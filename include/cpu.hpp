@@ -21,8 +21,10 @@
 
 #pragma once
 
+#include "arch.hpp"
 #include "compiler.hpp"
 #include "config.hpp"
+#include "memory.hpp"
 #include "types.hpp"
 
 class Cpu
@@ -56,12 +58,17 @@ class Cpu
             FEAT_SEP            = 11,
             FEAT_MCA            = 14,
             FEAT_ACPI           = 22,
+            FEAT_SSE2           = 26,
             FEAT_HTT            = 28,
+            FEAT_MONITOR        = 35,
             FEAT_VMX            = 37,
             FEAT_PCID           = 49,
             FEAT_TSC_DEADLINE   = 56,
+            FEAT_ARAT           = 66,
             FEAT_SMEP           = 103,
+            FEAT_ERMS           = 105,
             FEAT_1GB_PAGES      = 154,
+            FEAT_RDTSCP         = 155,
             FEAT_CMP_LEGACY     = 161,
             FEAT_SVM            = 162,
         };
@@ -158,10 +165,14 @@ class Cpu
 
         static uint32 name[12]              CPULOCAL;
         static uint32 features[6]           CPULOCAL;
+        static uint32 cstates               CPULOCAL;
         static bool bsp                     CPULOCAL;
+        static bool ready                   CPULOCAL;
 
         static void init();
 
+        static unsigned cstate (uint64, bool);
+
         ALWAYS_INLINE
         static inline bool feature (Feature f)
         {
@@ -174,6 +185,15 @@ class Cpu
             features[f / 32] &= ~(1U << f % 32);
         }
 
+        // CPU-local data is only mapped once a CPU runs on its own stack
+        ALWAYS_INLINE
+        static inline bool is_ready()
+        {
+            mword sp;
+            asm volatile ("mov " EXPAND (PREG(sp)) ", %0" : "=r" (sp));
+            return sp - CPU_LOCAL_STCK < PAGE_SIZE && ready;
+        }
+
         ALWAYS_INLINE
         static inline void preempt_disable()
         {
@@ -186,6 +206,24 @@ class Cpu
             asm volatile ("sti" : : : "memory");
         }
 
+        ALWAYS_INLINE
+        static inline void halt()
+        {
+            asm volatile ("sti; hlt; cli" : : : "memory");
+        }
+
+        ALWAYS_INLINE
+        static inline void monitor (void const *addr)
+        {
+            asm volatile ("monitor" : : "a" (addr), "c" (0), "d" (0));
+        }
+
+        ALWAYS_INLINE
+        static inline void mwait (unsigned c)
+        {
+            asm volatile ("sti; mwait; cli" : : "a" ((c - 1) << 4 | ((cstates >> 4 * c & 0xf) - 1)), "c" (0) : "memory");
+        }
+
         ALWAYS_INLINE
         static inline void cpuid (unsigned leaf, uint32 &eax, uint32 &ebx, uint32 &ecx, uint32 &edx)
         {
@@ -0,0 +1,44 @@
+/*
+ * Deadline Period Descriptor (DPD)
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "compiler.hpp"
+
+class Dpd
+{
+    private:
+        mword val;
+
+    public:
+        // Period and deadline are specified in units of 32us
+        static unsigned const unit = 32;
+
+        ALWAYS_INLINE
+        inline explicit Dpd (mword v) : val (v) {}
+
+        ALWAYS_INLINE
+        inline unsigned period() const
+        {
+            return static_cast<unsigned>(val >> 16 & 0xffff) * unit;
+        }
+
+        ALWAYS_INLINE
+        inline unsigned deadline() const
+        {
+            unsigned d = static_cast<unsigned>(val & 0xffff) * unit;
+            return d ? d : period();
+        }
+};
@@ -31,6 +31,7 @@
 #include "timeout_hypercall.hpp"
 #include "tss.hpp"
 
+class Pt;
 class Utcb;
 
 class Ec : public Kobject, public Refcount, public Queue<Sc>
@@ -44,6 +45,10 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         Utcb *      utcb;
         Refptr<Pd>  pd;
         Ec *        partner;
+        Ec *        croot;
+        Ec *        ctail;
+        unsigned    clink;
+        Sc *        rsc;
         Ec *        prev;
         Ec *        next;
         Fpu *       fpu;
@@ -56,9 +61,27 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         };
         unsigned const evt;
         Timeout_hypercall timeout;
+        Crd         tmp;
+        Pt *        xpt;
+        uint64      xtsc;
+        unsigned    mc_cnt;
+        unsigned    mc_idx;
+        unsigned    mc_flg;
+        unsigned    scs;
 
         static Slab_cache cache;
 
+        // Cross-CPU calls waiting for the proxy EC of a CPU
+        static struct Xq {
+            Spinlock    lock;
+            Queue<Ec>   queue;
+            Ec *        proxy;
+            Sc *        sc;
+            Ec *        cur;
+            unsigned    prio;
+            bool        idle;
+        } xq[NUM_CPU];
+
         REGPARM (1)
         static void handle_exc (Exc_regs *) asm ("exc_handler");
 
@@ -110,11 +133,21 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         ALWAYS_INLINE
         inline Exc_regs *exc_regs() { return &regs; }
 
+        // The root of a call chain tracks its tail, callees track the root
+        ALWAYS_INLINE
+        inline Ec *root() { return rcap ? croot : this; }
+
         ALWAYS_INLINE
         inline void set_partner (Ec *p)
         {
+            Ec *r = root();
+
             partner = p;
             partner->rcap = this;
+            partner->rsc = rcap ? rsc : Sc::current;
+            partner->croot = r;
+            partner->clink = (rcap ? clink : 0) + 1;
+            r->ctail = p;
             Sc::ctr_link++;
         }
 
@@ -122,11 +155,34 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         inline unsigned clr_partner()
         {
             assert (partner == current);
+            root()->ctail = this;
             partner->rcap = nullptr;
             partner = nullptr;
             return Sc::ctr_link--;
         }
 
+        // Hand our caller to p, which takes our place at the chain tail
+        ALWAYS_INLINE
+        inline void fwd_partner (Ec *p)
+        {
+            Ec *c = rcap;
+
+            c->partner = p;
+            p->rcap = c;
+            p->rsc = rsc;
+            p->croot = croot;
+            p->clink = clink;
+            croot->ctail = p;
+            rcap = nullptr;
+        }
+
+        ALWAYS_INLINE
+        inline void rev_tmp()
+        {
+            pd->rev_tmp (tmp);
+            tmp = Crd (0);
+        }
+
         ALWAYS_INLINE
         inline void redirect_to_iret()
         {
@@ -156,10 +212,28 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         inline bool blocked() const { return next || !cont; }
 
         ALWAYS_INLINE
-        inline void set_timeout (uint64 t, Sm *s)
+        inline unsigned links() { return partner ? root()->ctail->clink - (rcap ? clink : 0) : 0; }
+
+        // An EC with several SCs would run on two CPUs if one SC moved it
+        ALWAYS_INLINE
+        inline bool bound() const { return !utcb || partner || rcap || timeout.active() || scs > 1; }
+
+        ALWAYS_INLINE
+        inline bool pinned() const { return bound() || this == current; }
+
+        void migrate (unsigned);
+
+        ALWAYS_INLINE
+        inline void bind_sc() { Atomic::add (scs, 1U); }
+
+        ALWAYS_INLINE
+        inline void unbind_sc() { Atomic::sub (scs, 1U); }
+
+        ALWAYS_INLINE
+        inline void set_timeout (uint64 t, Sm *s, mword slack)
         {
             if (EXPECT_FALSE (t))
-                timeout.enqueue (t, s);
+                timeout.enqueue (t, s, slack);
         }
 
         ALWAYS_INLINE
@@ -195,10 +269,21 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
                 Counter::print<1,16> (++Counter::helping, Console_vga::COLOR_LIGHT_WHITE, SPN_HLP);
                 current->cont = c;
 
-                if (EXPECT_TRUE (++Sc::ctr_loop < 100))
+                // Run the busy server on our SC, charging the client it works for
+                if (EXPECT_TRUE (++Sc::ctr_loop < Sc::help_limit)) {
+                    Sc::donate (rsc);
                     activate();
+                }
+
+                // Helping did not get through, lend our priority to the client and
+                // yield to the tail of our level so that it actually gets to run.
+                // A client SC on another CPU is not boosted, its run queue is not ours
+                Counter::help_yield++;
 
-                die ("Livelock");
+                if (rsc)
+                    rsc->boost (Sc::current->prio);
+
+                Sc::schedule (false, true);
             }
         }
 
@@ -264,6 +349,25 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         HOT NORETURN
         static void sys_reply();
 
+        NORETURN
+        static void sys_forward();
+
+        NORETURN
+        static void sys_multicall();
+
+        NORETURN
+        static void multicall_next();
+
+        NORETURN
+        static void xcpu_call (Pt *);
+
+        NORETURN
+        static void xcpu_proxy();
+
+        template <Sys_regs::Status>
+        NORETURN
+        static void xcpu_reply();
+
         NORETURN
         static void sys_create_pd();
 
@@ -306,6 +410,8 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         NORETURN
         static void idle();
 
+        static void xcpu_init();
+
         NORETURN
         static void root_invoke();
 
@@ -27,10 +27,12 @@ extern char GIT_VER;
 extern char PAGE_0;
 extern char PAGE_1;
 extern char PAGE_H;
+extern char PAGE_C;
 
 extern char FRAME_0;
 extern char FRAME_1;
 extern char FRAME_H;
+extern char FRAME_C;
 
 extern char PDBR;
 
@@ -22,14 +22,21 @@
 
 #include "assert.hpp"
 #include "config.hpp"
+#include "spinlock.hpp"
 
 class Ioapic;
 class Sm;
 
 class Gsi
 {
+    private:
+        static Spinlock lock;
+
     public:
         Sm *            sm;
+        Sm *            ntf;
+        mword           bits;
+        unsigned        seq;
         Ioapic *        ioapic;
         union {
             uint16      irt;
@@ -49,6 +56,9 @@ class Gsi
 
         static void mask (unsigned);
         static void unmask (unsigned);
+        static void unmask (Sm *, mword);
+
+        static void bind (unsigned, Sm *, mword);
 
         ALWAYS_INLINE
         static inline unsigned irq_to_gsi (unsigned irq)
@@ -41,7 +41,8 @@ class Hip_mem
     public:
         enum {
             HYPERVISOR  = -1u,
-            MB_MODULE   = -2u
+            MB_MODULE   = -2u,
+            CLOCK       = -3u
         };
 
         uint64  addr;
@@ -86,7 +87,10 @@ class Hip
         ALWAYS_INLINE
         static inline Hip *hip()
         {
-            return reinterpret_cast<Hip *>(&PAGE_H);
+            // Hide the symbol from the compiler's object-size tracking
+            Hip *h = reinterpret_cast<Hip *>(&PAGE_H);
+            asm ("" : "+r" (h));
+            return h;
         }
 
         static uint32 feature()
@@ -109,6 +113,11 @@ class Hip
             return cpu < NUM_CPU && hip()->cpu_desc[cpu].flags & 1;
         }
 
+        static Hip_cpu const *cpu_topo (unsigned long cpu)
+        {
+            return hip()->cpu_desc + cpu;
+        }
+
         INIT
         static void build (mword);
 
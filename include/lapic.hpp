@@ -141,6 +141,15 @@ class Lapic
                 Msr::write (Msr::IA32_TSC_DEADLINE, tsc);
         }
 
+        ALWAYS_INLINE
+        static inline void clr_timer()
+        {
+            if (freq_bus)
+                write (LAPIC_TMR_ICR, 0);
+            else
+                Msr::write<uint64>(Msr::IA32_TSC_DEADLINE, 0);
+        }
+
         ALWAYS_INLINE
         static inline unsigned get_timer()
         {
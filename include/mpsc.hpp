@@ -0,0 +1,61 @@
+/*
+ * Lock-Free Multi-Producer Single-Consumer Queue
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "atomic.hpp"
+#include "compiler.hpp"
+
+/*
+ * No constructor: an all-zero queue is empty, so it can live in
+ * CPU-local data
+ */
+template <typename T>
+class Mpsc
+{
+    private:
+        T *headptr;
+
+    public:
+        ALWAYS_INLINE
+        inline bool empty() { return !ACCESS_ONCE (headptr); }
+
+        // Returns true if the queue was empty and the consumer needs a kick
+        ALWAYS_INLINE
+        inline bool enqueue (T *t)
+        {
+            T *h;
+
+            do t->next = h = ACCESS_ONCE (headptr); while (!Atomic::cmp_swap (headptr, h, t));
+
+            return !h;
+        }
+
+        // Only the consumer takes elements, all at once and in arrival order
+        ALWAYS_INLINE
+        inline T *dequeue_all()
+        {
+            T *fifo = nullptr;
+
+            // Producers push in LIFO order; restore arrival order
+            for (T *ptr = Atomic::exchange (headptr, static_cast<T *>(nullptr)), *n; ptr; ptr = n) {
+                n = ptr->next;
+                ptr->next = fifo;
+                fifo = ptr;
+            }
+
+            return fifo;
+        }
+};
@@ -30,12 +30,17 @@ class Pd : public Kobject, public Refcount, public Space_mem, public Space_pio,
     private:
         static Slab_cache cache;
 
+        static mword const tmp_order = 10;
+
         WARN_UNUSED_RESULT
         mword clamp (mword,   mword &, mword, mword);
 
         WARN_UNUSED_RESULT
         mword clamp (mword &, mword &, mword, mword, mword);
 
+        WARN_UNUSED_RESULT
+        mword covered (Space_mem *, mword, mword);
+
     public:
         static Pd *current CPULOCAL_HOT;
         static Pd kern, root;
@@ -90,12 +95,15 @@ class Pd : public Kobject, public Refcount, public Space_mem, public Space_pio,
         template <typename>
         void revoke (mword, mword, mword, bool);
 
-        void xfer_items (Pd *, Crd, Crd, Xfer *, Xfer *, unsigned long);
+        void xfer_items (Pd *, Crd, Crd, Xfer *, Xfer *, unsigned long, Crd * = nullptr);
 
         void xlt_crd (Pd *, Crd, Crd &);
         void del_crd (Pd *, Crd, Crd &, mword = 0, mword = 0);
         void rev_crd (Crd, bool);
 
+        void tmp_crd (Pd *, Crd, Crd &, mword = 0);
+        void rev_tmp (Crd);
+
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return cache.alloc(); }
 
@@ -0,0 +1,38 @@
+/*
+ * Preemption Guard
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "cpu.hpp"
+
+class Preempt_guard
+{
+    private:
+        mword _flags;
+
+    public:
+        ALWAYS_INLINE
+        inline Preempt_guard()
+        {
+            asm volatile ("pushf; pop %0; cli" : "=r" (_flags) : : "memory");
+        }
+
+        ALWAYS_INLINE
+        inline ~Preempt_guard()
+        {
+            if (_flags & Cpu::EFL_IF)
+                Cpu::preempt_enable();
+        }
+};
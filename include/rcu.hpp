@@ -19,6 +19,8 @@
 #pragma once
 
 #include "compiler.hpp"
+#include "cpu.hpp"
+#include "cpuset.hpp"
 #include "types.hpp"
 
 class Rcu_elem
@@ -65,6 +67,7 @@ class Rcu
     private:
         static mword count;
         static mword state;
+        static Cpuset idle;
 
         static mword l_batch    CPULOCAL;
         static mword c_batch    CPULOCAL;
@@ -94,4 +97,9 @@ class Rcu
 
         static void quiet();
         static void update();
+
+        static bool idle_enter();
+
+        ALWAYS_INLINE
+        static inline void idle_leave() { idle.clr (Cpu::id); }
 };
@@ -21,52 +21,141 @@
 
 #pragma once
 
+#include "bits.hpp"
 #include "compiler.hpp"
+#include "cpuset.hpp"
+#include "mpsc.hpp"
 
 class Ec;
 
 class Sc : public Kobject
 {
+    friend class Mpsc<Sc>;
     friend class Queue<Sc>;
 
     public:
         Refptr<Ec> const ec;
-        unsigned const cpu;
-        unsigned const prio;
-        uint64 const budget;
+        unsigned cpu;
+        unsigned prio;
+        unsigned base;
+        uint64 budget;
+        uint64 const period;
+        uint64 const deadline;
         uint64 time;
+        bool const mig;
+
+        static unsigned const hist_buckets = 32;
+
+        uint32 hist_wait[hist_buckets];
+        uint32 hist_run[hist_buckets];
 
     private:
         uint64 left;
         Sc *prev, *next;
         uint64 tsc;
+        uint64 wake;
+        uint64 dl;
+        unsigned util;
+        unsigned dst;
+        unsigned new_prio;
+        unsigned new_quantum;
+        mword upd;
+
+        enum
+        {
+            UPD_CPU = 1UL << 0,
+            UPD_QPD = 1UL << 1,
+        };
 
         static unsigned const priorities = 128;
+        static unsigned const prio_bits = 8 * sizeof (mword);
 
         static Slab_cache cache;
 
         static struct Rq {
-            Spinlock    lock;
-            Sc *        queue;
-        } rq CPULOCAL;
+            Mpsc<Sc>    queue;
+            Cpuset      steal;
+            unsigned    ready;
+            unsigned    ready_mig;
+            unsigned    poll;
+            unsigned    upd;
+            unsigned    stl;
+            uint64      stl_tsc;
+        } rq CPULOCAL ALIGNED (64);
 
         static Sc *list[priorities] CPULOCAL;
 
-        static unsigned prio_top CPULOCAL;
+        static mword prio_map[priorities / prio_bits] CPULOCAL;
+
+        static mword prio_sum CPULOCAL;
+
+        ALWAYS_INLINE
+        static inline void prio_set (unsigned p)
+        {
+            prio_map[p / prio_bits] |= 1UL << p % prio_bits;
+            prio_sum |= 1UL << p / prio_bits;
+        }
+
+        ALWAYS_INLINE
+        static inline void prio_clr (unsigned p)
+        {
+            if (!(prio_map[p / prio_bits] &= ~(1UL << p % prio_bits)))
+                prio_sum &= ~(1UL << p / prio_bits);
+        }
+
+        ALWAYS_INLINE
+        static inline unsigned prio_top()
+        {
+            long int w = bit_scan_reverse (prio_sum);
+            return w < 0 ? 0 : static_cast<unsigned>(w * prio_bits + bit_scan_reverse (prio_map[w]));
+        }
+
+        ALWAYS_INLINE
+        inline bool before (Sc const *s) const
+        {
+            return period ? !s->period || dl < s->dl : !s->period && left;
+        }
+
+        // Log2 histogram of TSC cycles, the last bucket saturates
+        ALWAYS_INLINE
+        static inline void hist_add (uint32 *h, uint64 d)
+        {
+            long int b = d >> 32 ? static_cast<long int>(hist_buckets) - 1 : bit_scan_reverse (static_cast<mword>(d));
+            h[b < 0 ? 0 : b]++;
+        }
+
+        void cbs_update (uint64);
 
-        void ready_enqueue (uint64);
+        void ready_enqueue (uint64, bool = true);
         void ready_dequeue (uint64);
 
+        static Sc *steal_candidate();
+        static void steal();
+        static void handoff();
+
+        bool update();
+        void request();
+        void defer_update();
+
+        static Sc *update_candidate();
+        static void update_ready();
+
     public:
         static Sc *     current     CPULOCAL_HOT;
         static unsigned ctr_link    CPULOCAL;
         static unsigned ctr_loop    CPULOCAL;
+        static Sc *     donee       CPULOCAL;
+        static uint64   donee_tsc   CPULOCAL;
+
+        static unsigned const help_limit = 32;
 
         static unsigned const default_prio = 1;
         static unsigned const default_quantum = 10000;
 
         Sc (Pd *, mword, Ec *);
-        Sc (Pd *, mword, Ec *, unsigned, unsigned, unsigned);
+        Sc (Pd *, mword, Ec *, unsigned, unsigned, unsigned, bool = false, unsigned = 0, unsigned = 0);
+
+        ~Sc();
 
         ALWAYS_INLINE
         static inline Rq *remote (unsigned long c)
@@ -76,11 +165,29 @@ class Sc : public Kobject
 
         void remote_enqueue();
 
+        void set_cpu (unsigned);
+        void set_qpd (unsigned, unsigned);
+
+        void boost (unsigned);
+
+        static void donate (Sc *);
+        static void settle (uint64);
+
         static void rrq_handler();
         static void rke_handler();
+        static void stl_handler();
+
+        static void wait (unsigned);
+
+        ALWAYS_INLINE
+        static inline void balance()
+        {
+            if (rq.ready <= 1)
+                steal();
+        }
 
         NORETURN
-        static void schedule (bool = false);
+        static void schedule (bool = false, bool = false);
 
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return cache.alloc(); }
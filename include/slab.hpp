@@ -21,28 +21,73 @@
 #pragma once
 
 #include "buddy.hpp"
+#include "config.hpp"
 #include "initprio.hpp"
 
 class Slab;
 
+class Slab_mag
+{
+    public:
+        static unsigned long const rounds = 15;
+
+        Slab_mag *      next;
+        unsigned long   avail;
+        void *          obj[rounds];
+
+        ALWAYS_INLINE
+        inline bool full() const { return avail == rounds; }
+};
+
 class Slab_cache
 {
     private:
         Spinlock    lock;
         Slab *      curr;
         Slab *      head;
+        Slab_cache *link;
+        unsigned long slabs;
+        unsigned long empty;
+
+        // Empty slabs kept when objects are freed
+        static unsigned long const reserve = 1;
+
+        static Slab_cache *caches;
+
+        /*
+         * Magazine layer: a loaded and a previous magazine per CPU in
+         * front of a depot of full and empty magazines
+         */
+        Slab_mag *  loaded[NUM_CPU];
+        Slab_mag *  previous[NUM_CPU];
+        Spinlock    depot;
+        Slab_mag *  mag_full;
+        Slab_mag *  mag_empty;
+        bool const  mag;
+
+        static Slab_cache mags;
 
         /*
          * Back end allocator
          */
         void grow();
 
+        void *slab_alloc();
+        void slab_free (void *);
+        void slab_put (void *);
+
+        void release (Slab *);
+        unsigned long trim();
+
+        Slab_mag *depot_get (Slab_mag *&);
+        void depot_put (Slab_mag *);
+
     public:
         unsigned long size; // Size of an element
         unsigned long buff; // Size of an element buffer (includes link field)
         unsigned long elem; // Number of elements
 
-        Slab_cache (unsigned long elem_size, unsigned elem_align);
+        Slab_cache (unsigned long elem_size, unsigned elem_align, bool = true);
 
         /*
          * Front end allocator
@@ -53,6 +98,8 @@ class Slab_cache
          * Front end deallocator
          */
         void free (void *ptr);
+
+        static unsigned long shrink();
 };
 
 class Slab
@@ -27,14 +27,35 @@ class Sm : public Kobject, public Queue<Ec>
 {
     private:
         mword counter;
+        mword *word;
 
         static Slab_cache cache;
 
+        // Take back the decrement of a timed-out waiter unless an up already claimed it
+        ALWAYS_INLINE
+        inline bool withdraw()
+        {
+            for (mword v; static_cast<long>(v = *word) < 0;)
+                if (Atomic::cmp_swap (*word, v, v + 1))
+                    return true;
+
+            return false;
+        }
+
     public:
-        Sm (Pd *, mword, mword = 0);
+        bool const notify;
+        mword gsi;
+
+        Sm (Pd *, mword, mword = 0, bool = false);
+
+        bool map (Pd *, mword);
+        void unmap (Pd *, mword);
+
+        ALWAYS_INLINE
+        inline bool mapped() const { return word; }
 
         ALWAYS_INLINE
-        inline void dn (bool zero, uint64 t)
+        inline void dn (bool zero, uint64 t, mword slack = 0)
         {
             Ec *ec = Ec::current;
 
@@ -48,7 +69,7 @@ class Sm : public Kobject, public Queue<Ec>
                 enqueue (ec);
             }
 
-            ec->set_timeout (t, this);
+            ec->set_timeout (t, this, slack);
 
             ec->block_sc();
         }
@@ -69,6 +90,47 @@ class Sm : public Kobject, public Queue<Ec>
             ec->release (Ec::sys_finish<Sys_regs::SUCCESS, true>);
         }
 
+        // Notifications accumulate signal bits in the counter word
+        ALWAYS_INLINE
+        inline void signal (mword bits)
+        {
+            Ec *ec;
+
+            {   Lock_guard <Spinlock> guard (lock);
+
+                counter |= bits;
+
+                if (!dequeue (ec = head()))
+                    return;
+            }
+
+            ec->release (Ec::sys_sm_ctrl);
+        }
+
+        ALWAYS_INLINE
+        inline mword collect (uint64 t, mword slack)
+        {
+            Ec *ec = Ec::current;
+
+            {   Lock_guard <Spinlock> guard (lock);
+
+                if (counter) {
+                    mword bits = counter;
+                    counter = 0;
+                    return bits;
+                }
+
+                enqueue (ec);
+            }
+
+            ec->set_timeout (t, this, slack);
+
+            ec->block_sc();
+
+            // Signalled before we blocked, resume the continuation
+            ec->make_current();
+        }
+
         ALWAYS_INLINE
         inline void timeout (Ec *ec)
         {
@@ -76,6 +138,18 @@ class Sm : public Kobject, public Queue<Ec>
 
                 if (!dequeue (ec))
                     return;
+
+                if (EXPECT_FALSE (word) && !withdraw()) {
+
+                    if (!counter) {
+                        enqueue (ec);
+                        return;
+                    }
+
+                    counter--;
+                    ec->release (Ec::sys_finish<Sys_regs::SUCCESS, true>);
+                    return;
+                }
             }
 
             ec->release (Ec::sys_finish<Sys_regs::COM_TIM>);
@@ -45,6 +45,14 @@ class Spinlock
                           : "+Q" (tmp), "+m" (val) : : "memory");
         }
 
+        ALWAYS_INLINE
+        inline bool try_lock()
+        {
+            uint16 tmp = val;
+
+            return static_cast<uint8>(tmp >> 8) == static_cast<uint8>(tmp) && __sync_bool_compare_and_swap (&val, tmp, static_cast<uint16>(tmp + 0x100));
+        }
+
         ALWAYS_INLINE
         inline void unlock()
         {
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "dpd.hpp"
 #include "qpd.hpp"
 
 class Sys_call : public Sys_regs
@@ -30,13 +31,38 @@ class Sys_call : public Sys_regs
         {
             DISABLE_BLOCKING    = 1ul << 0,
             DISABLE_DONATION    = 1ul << 1,
-            DISABLE_REPLYCAP    = 1ul << 2
+            DISABLE_REPLYCAP    = 1ul << 2,
+            CROSS_CPU           = 1ul << 3
         };
 
         ALWAYS_INLINE
         inline unsigned long pt() const { return ARG_1 >> 8; }
 };
 
+class Sys_reply : public Sys_regs
+{
+    public:
+        enum
+        {
+            DISABLE_BLOCKING    = 1ul << 0,
+            FORWARD             = 1ul << 3
+        };
+
+        ALWAYS_INLINE
+        inline unsigned long pt() const { return ARG_1 >> 8; }
+};
+
+class Sys_multicall : public Sys_regs
+{
+    public:
+        enum
+        {
+            STOP_ON_ERROR       = 1ul << 0
+        };
+
+        static unsigned const words = 5;
+};
+
 class Sys_create_pd : public Sys_regs
 {
     public:
@@ -75,6 +101,12 @@ class Sys_create_ec : public Sys_regs
 class Sys_create_sc : public Sys_regs
 {
     public:
+        enum
+        {
+            MIGRATABLE          = 1ul << 0,
+            DEADLINE            = 1ul << 1
+        };
+
         ALWAYS_INLINE
         inline unsigned long sel() const { return ARG_1 >> 8; }
 
@@ -86,6 +118,9 @@ class Sys_create_sc : public Sys_regs
 
         ALWAYS_INLINE
         inline Qpd qpd() const { return Qpd (ARG_4); }
+
+        ALWAYS_INLINE
+        inline Dpd dpd() const { return Dpd (ARG_5); }
 };
 
 class Sys_create_pt : public Sys_regs
@@ -118,6 +153,15 @@ class Sys_create_sm : public Sys_regs
 
         ALWAYS_INLINE
         inline mword cnt() const { return ARG_3; }
+
+        ALWAYS_INLINE
+        inline bool notify() const { return flags() & 1; }
+
+        ALWAYS_INLINE
+        inline bool user() const { return flags() & 2; }
+
+        ALWAYS_INLINE
+        inline mword va() const { return ARG_4; }
 };
 
 class Sys_revoke : public Sys_regs
@@ -147,6 +191,15 @@ class Sys_sc_ctrl : public Sys_regs
         ALWAYS_INLINE
         inline unsigned long sc() const { return ARG_1 >> 8; }
 
+        ALWAYS_INLINE
+        inline unsigned op() const { return flags() & 0x3; }
+
+        ALWAYS_INLINE
+        inline unsigned cpu() const { return static_cast<unsigned>(ARG_2); }
+
+        ALWAYS_INLINE
+        inline Qpd qpd() const { return Qpd (ARG_2); }
+
         ALWAYS_INLINE
         inline void set_time (uint64 val)
         {
@@ -179,6 +232,15 @@ class Sys_sm_ctrl : public Sys_regs
 
         ALWAYS_INLINE
         inline uint64 time() const { return static_cast<uint64>(ARG_2) << 32 | ARG_3; }
+
+        ALWAYS_INLINE
+        inline mword slack() const { return ARG_4; }
+
+        ALWAYS_INLINE
+        inline mword bits() const { return ARG_2; }
+
+        ALWAYS_INLINE
+        inline void set_bits (mword b) { ARG_2 = b; }
 };
 
 class Sys_assign_pci : public Sys_regs
@@ -206,6 +268,15 @@ class Sys_assign_gsi : public Sys_regs
         ALWAYS_INLINE
         inline unsigned cpu() const { return static_cast<unsigned>(ARG_3); }
 
+        ALWAYS_INLINE
+        inline bool notify() const { return flags() & 1; }
+
+        ALWAYS_INLINE
+        inline unsigned long ntf() const { return ARG_4; }
+
+        ALWAYS_INLINE
+        inline mword bits() const { return ARG_5; }
+
         ALWAYS_INLINE
         inline void set_msi (uint64 val)
         {
@@ -22,6 +22,16 @@
 
 class Timeout
 {
+    private:
+        Timeout *child;
+
+        static uint64 armed CPULOCAL;
+
+        static Timeout *meld (Timeout *, Timeout *);
+        static Timeout *merge_pairs (Timeout *);
+
+        static void arm (uint64);
+
     protected:
         Timeout *prev, *next;
         uint64 time;
@@ -29,16 +39,20 @@ class Timeout
         virtual void trigger() = 0;
 
     public:
-        static Timeout *list CPULOCAL;
+        static Timeout *heap CPULOCAL;
 
         ALWAYS_INLINE
-        inline Timeout() : prev (nullptr), next (nullptr), time (0) {}
+        inline Timeout() : child (nullptr), prev (nullptr), next (nullptr), time (0) {}
 
         ALWAYS_INLINE
-        inline bool active() const { return prev || list == this; }
+        inline bool active() const { return prev || heap == this; }
 
         void enqueue (uint64);
         uint64 dequeue();
 
+        ALWAYS_INLINE
+        static inline uint64 earliest() { return heap ? heap->time : ~0ULL; }
+
         static void check();
+        static void disarm();
 };
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "bits.hpp"
 #include "timeout.hpp"
 
 class Ec;
@@ -35,5 +36,17 @@ class Timeout_hypercall : public Timeout
         inline Timeout_hypercall (Ec *e) : ec (e) {}
 
         ALWAYS_INLINE
-        inline void enqueue (uint64 t, Sm *s) { sm = s; Timeout::enqueue (t); }
+        inline void enqueue (uint64 t, Sm *s, mword slack)
+        {
+            sm = s;
+
+            // Round up to the coarsest boundary within the slack so that nearby timeouts expire together
+            if (slack) {
+                uint64 g = 1ULL << bit_scan_reverse (slack), a = (t + g - 1) & ~(g - 1);
+                if (a > t)
+                    t = a;
+            }
+
+            Timeout::enqueue (t);
+        }
 };
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "buddy.hpp"
+#include "cpu.hpp"
 #include "crd.hpp"
 #include "util.hpp"
 
@@ -106,21 +107,43 @@ class Utcb : public Utcb_head, private Utcb_data
         inline mword ui() const { return min (words / 1, ucnt()); }
         inline mword ti() const { return min (words / 2, tcnt()); }
 
+        // Short messages stay in registers, long ones use string moves
         ALWAYS_INLINE NONNULL
         inline void save (Utcb *dst)
         {
-            register mword n = ui();
+            mword n = ui(), *d = dst->mr, *s = mr;
 
             dst->items = items;
-#if 0
-            mword *d = dst->mr, *s = mr;
-            asm volatile ("rep; movsl" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
+
+            switch (n) {
+                case 8: d[7] = s[7];    // fall through
+                case 7: d[6] = s[6];    // fall through
+                case 6: d[5] = s[5];    // fall through
+                case 5: d[4] = s[4];    // fall through
+                case 4: d[3] = s[3];    // fall through
+                case 3: d[2] = s[2];    // fall through
+                case 2: d[1] = s[1];    // fall through
+                case 1: d[0] = s[0];    // fall through
+                case 0: return;
+            }
+
+            if (Cpu::feature (Cpu::FEAT_ERMS)) {
+                n *= sizeof (mword);
+                asm volatile ("rep; movsb" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
+            } else
+#ifdef __i386__
+                asm volatile ("rep; movsl" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
 #else
-            for (unsigned long i = 0; i < n; i++)
-                dst->mr[i] = mr[i];
+                asm volatile ("rep; movsq" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
 #endif
         }
 
+        ALWAYS_INLINE
+        inline mword get_mr (unsigned long i) const { return mr[i]; }
+
+        ALWAYS_INLINE
+        inline void set_mr (unsigned long i, mword v) { mr[i] = v; }
+
         ALWAYS_INLINE
         inline Xfer *xfer() { return reinterpret_cast<Xfer *>(this) + PAGE_SIZE / sizeof (Xfer) - 1; }
 
@@ -35,3 +35,4 @@
 
 #define VEC_IPI_RRQ     (VEC_IPI + 0)
 #define VEC_IPI_RKE     (VEC_IPI + 1)
+#define VEC_IPI_STL     (VEC_IPI + 2)
@@ -18,6 +18,7 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "clock.hpp"
 #include "compiler.hpp"
 #include "ec.hpp"
 #include "hip.hpp"
@@ -34,13 +35,18 @@ void bootstrap()
     Ec::current = new Ec (Pd::current = &Pd::kern, Ec::idle, Cpu::id);
     Space_obj::insert_root (Sc::current = new Sc (&Pd::kern, Cpu::id, Ec::current));
 
+    Ec::xcpu_init();
+
     // Barrier: wait for all ECs to arrive here
     for (Atomic::add (barrier, 1UL); barrier != Cpu::online; pause()) ;
 
     Msr::write<uint64>(Msr::IA32_TSC, 0);
 
+    Clock::sync();
+
     // Create root task
     if (Cpu::bsp) {
+        Clock::init();
         Hip::add_check();
         Ec *root_ec = new Ec (&Pd::root, NUM_EXC + 1, &Pd::root, Ec::root_invoke, Cpu::id, 0, USER_ADDR - 2 * PAGE_SIZE, 0);
         Sc *root_sc = new Sc (&Pd::root, NUM_EXC + 2, root_ec, Cpu::id, Sc::default_prio, Sc::default_quantum);
@@ -19,12 +19,18 @@
  */
 
 #include "assert.hpp"
+#include "atomic.hpp"
 #include "bits.hpp"
 #include "buddy.hpp"
+#include "counter.hpp"
+#include "cpu.hpp"
 #include "initprio.hpp"
 #include "lock_guard.hpp"
+#include "preempt_guard.hpp"
+#include "slab.hpp"
 #include "stdio.hpp"
 #include "string.hpp"
+#include "x86.hpp"
 
 extern char _mempool_p, _mempool_l, _mempool_f, _mempool_e;
 
@@ -68,6 +74,10 @@ Buddy::Buddy (mword phys, mword virt, mword f_addr, size_t size)
     for (unsigned i = 0; i < order; i++)
         head[i].next = head[i].prev = head + i;
 
+    // Keep the hot lists of all CPUs to a small fraction of the pool
+    hot_high = static_cast<unsigned>(min (static_cast<mword>(HOT_MAX), static_cast<mword>(max_idx - min_idx) / (NUM_CPU * 16)));
+    zero_limit = static_cast<unsigned>((max_idx - min_idx) / 16);
+
     for (mword i = f_addr; i < virt + size; i += PAGE_SIZE)
         free (i);
 }
@@ -80,8 +90,155 @@ Buddy::Buddy (mword phys, mword virt, mword f_addr, size_t size)
  */
 void *Buddy::alloc (unsigned short ord, Fill fill)
 {
+    Preempt_guard preempt;
+
+    Block *block = nullptr;
+
+    bool pool = !ord && fill == FILL_0 && Cpu::is_ready();
+
+    if (EXPECT_TRUE (pool)) {
+
+        {   Lock_guard <Spinlock> local (hot_lock[Cpu::id]);
+
+            if ((block = zero[Cpu::id])) {
+                zero[Cpu::id] = block->next;
+                zero_cnt[Cpu::id]--;
+            }
+        }
+
+        if (EXPECT_TRUE (block)) {
+            Atomic::sub (zero_total, 1U);
+            Counter::zero_hit++;
+            return reinterpret_cast<void *>(index_to_page (block_to_index (block)));
+        }
+    }
+
+    while (EXPECT_FALSE (!(block = take (ord))))
+        if (!reclaim())
+            Console::panic ("Out of memory");
+
+    mword virt = index_to_page (block_to_index (block));
+
+    uint64 t = pool ? rdtsc() : 0;
+
+    if (fill)
+        memset (reinterpret_cast<void *>(virt), fill == FILL_0 ? 0 : -1, 1ul << (block->ord + PAGE_BITS));
+
+    if (pool) {
+        Counter::zero_miss++;
+        Counter::cycles_zero += rdtsc() - t;
+    }
+
+    return reinterpret_cast<void *>(virt);
+}
+
+/*
+ * Top up this CPU's pool of zeroed pages from the idle loop. Non-temporal
+ * stores keep the zeroing from evicting the cache contents. The pools of
+ * all CPUs together hold at most zero_limit pages.
+ */
+void Buddy::prezero()
+{
+    if (!Cpu::feature (Cpu::FEAT_SSE2))
+        return;
+
+    for (unsigned i = 0; i < ZERO_BATCH && zero_cnt[Cpu::id] < ZERO_MAX && zero_total < zero_limit; i++) {
+
+        Block *block = take (0);
+
+        if (!block)
+            break;
+
+        mword *w = reinterpret_cast<mword *>(index_to_page (block_to_index (block)));
+
+        for (mword *e = w + PAGE_SIZE / sizeof *w; w < e; w += 4)
+            asm volatile ("movnti %4, %0; movnti %4, %1; movnti %4, %2; movnti %4, %3" : "=m" (w[0]), "=m" (w[1]), "=m" (w[2]), "=m" (w[3]) : "r" (0UL));
+
+        // Other CPUs may drain the pool and reuse the page
+        asm volatile ("sfence" : : : "memory");
+
+        Atomic::add (zero_total, 1U);
+
+        Lock_guard <Spinlock> local (hot_lock[Cpu::id]);
+
+        block->next = zero[Cpu::id];
+        zero[Cpu::id] = block;
+        zero_cnt[Cpu::id]++;
+    }
+}
+
+Buddy::Block *Buddy::take (unsigned short ord)
+{
+    if (EXPECT_TRUE (ord < HOT_ORD && hot_high && Cpu::is_ready())) {
+
+        Lock_guard <Spinlock> local (hot_lock[Cpu::id]);
+
+        Block *&h = hot[Cpu::id][ord];
+        unsigned &c = hot_cnt[Cpu::id][ord];
+
+        if (EXPECT_FALSE (!c)) {
+
+            Lock_guard <Spinlock> guard (lock);
+
+            for (Block *b; c < (hot_high + 1) / 2 && (b = alloc_block (ord)); c++) {
+                b->next = h;
+                h = b;
+            }
+
+            if (EXPECT_FALSE (!c))
+                return nullptr;
+        }
+
+        Block *block = h;
+        h = block->next;
+        c--;
+
+        return block;
+    }
+
     Lock_guard <Spinlock> guard (lock);
 
+    return alloc_block (ord);
+}
+
+/*
+ * Return empty slabs and the hot and zeroed blocks of all CPUs to the
+ * free lists.
+ * @return          Number of blocks returned
+ */
+unsigned long Buddy::reclaim()
+{
+    unsigned long n = Slab_cache::shrink();
+
+    for (unsigned cpu = 0; cpu < NUM_CPU; cpu++) {
+
+        Lock_guard <Spinlock> local (hot_lock[cpu]);
+        Lock_guard <Spinlock> guard (lock);
+
+        for (unsigned o = 0; o < HOT_ORD; o++) {
+
+            Block *&h = hot[cpu][o];
+
+            for (; h; n++, hot_cnt[cpu][o]--) {
+                Block *b = h;
+                h = b->next;
+                free_block (b);
+            }
+        }
+
+        for (Block *&z = zero[cpu]; z; n++, zero_cnt[cpu]--) {
+            Block *b = z;
+            z = b->next;
+            free_block (b);
+            Atomic::sub (zero_total, 1U);
+        }
+    }
+
+    return n;
+}
+
+Buddy::Block *Buddy::alloc_block (unsigned short ord)
+{
     for (unsigned short j = ord; j < order; j++) {
 
         if (head[j].next == head + j)
@@ -101,18 +258,13 @@ void *Buddy::alloc (unsigned short ord, Fill fill)
             head[j].next = head[j].prev = buddy;
         }
 
-        mword virt = index_to_page (block_to_index (block));
-
         // Ensure corresponding physical block is order-aligned
-        assert ((virt_to_phys (virt) & ((1ul << (block->ord + PAGE_BITS)) - 1)) == 0);
+        assert ((virt_to_phys (index_to_page (block_to_index (block))) & ((1ul << (block->ord + PAGE_BITS)) - 1)) == 0);
 
-        if (fill)
-            memset (reinterpret_cast<void *>(virt), fill == FILL_0 ? 0 : -1, 1ul << (block->ord + PAGE_BITS));
-
-        return reinterpret_cast<void *>(virt);
+        return block;
     }
 
-    Console::panic ("Out of memory");
+    return nullptr;
 }
 
 /*
@@ -134,8 +286,40 @@ void Buddy::free (mword virt)
     // Ensure corresponding physical block is order-aligned
     assert ((virt_to_phys (virt) & ((1ul << (block->ord + PAGE_BITS)) - 1)) == 0);
 
+    Preempt_guard preempt;
+
+    // Cached blocks stay tagged as used and are never merged
+    if (EXPECT_TRUE (block->ord < HOT_ORD && hot_high && Cpu::is_ready())) {
+
+        Lock_guard <Spinlock> local (hot_lock[Cpu::id]);
+
+        Block *&h = hot[Cpu::id][block->ord];
+        unsigned &c = hot_cnt[Cpu::id][block->ord];
+
+        block->next = h;
+        h = block;
+
+        if (EXPECT_TRUE (++c <= hot_high))
+            return;
+
+        Lock_guard <Spinlock> guard (lock);
+
+        for (; c > hot_high / 2; c--) {
+            Block *b = h;
+            h = b->next;
+            free_block (b);
+        }
+
+        return;
+    }
+
     Lock_guard <Spinlock> guard (lock);
 
+    free_block (block);
+}
+
+void Buddy::free_block (Block *block)
+{
     unsigned short ord;
     for (ord = block->ord; ord < order - 1; ord++) {
 
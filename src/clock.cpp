@@ -0,0 +1,93 @@
+/*
+ * User-Readable Clock Page
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include "bits.hpp"
+#include "clock.hpp"
+#include "cpu.hpp"
+#include "lapic.hpp"
+#include "lock_guard.hpp"
+#include "msr.hpp"
+#include "x86.hpp"
+
+Spinlock    Clock::lock;
+uint64      Clock::ref;
+mword       Clock::ack;
+
+void Clock::init()
+{
+    Clock *c = clock();
+
+    uint32 dummy;
+
+    Lock_guard <Spinlock> guard (lock);
+
+    c->write_begin();
+
+    c->freq_tsc = Lapic::freq_tsc;
+    c->shift    = 24;
+    c->mult     = static_cast<uint32>(div64 (1000000ULL << 24, Lapic::freq_tsc, &dummy));
+    c->tsc_base = 0;
+    c->ns_base  = 0;
+
+    c->write_end();
+}
+
+/*
+ * Measure the TSC of each AP against the BSP after the reset in bootstrap.
+ * The BSP answers one AP at a time with its current TSC, which the AP
+ * matches with the midpoint of its own reads around the exchange.
+ */
+void Clock::sync()
+{
+    if (Cpu::feature (Cpu::FEAT_RDTSCP))
+        Msr::write<uint64>(Msr::IA32_TSC_AUX, Cpu::id);
+
+    if (Cpu::bsp) {
+
+        for (unsigned n = 1; n < Cpu::online; n++) {
+
+            while (!ACCESS_ONCE (ack))
+                pause();
+
+            ref = rdtsc();
+            barrier();
+            ACCESS_ONCE (ack) = 2;
+
+            while (ACCESS_ONCE (ack))
+                pause();
+        }
+
+        return;
+    }
+
+    Lock_guard <Spinlock> guard (lock);
+
+    uint64 t = rdtsc();
+
+    ACCESS_ONCE (ack) = 1;
+
+    while (ACCESS_ONCE (ack) != 2)
+        pause();
+
+    barrier();
+
+    Clock *c = clock();
+
+    c->write_begin();
+    c->tsc_adj[Cpu::id] = ref - t - (rdtsc() - t) / 2;
+    c->write_end();
+
+    ACCESS_ONCE (ack) = 0;
+}
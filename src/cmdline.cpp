@@ -29,6 +29,7 @@ bool Cmdline::serial;
 bool Cmdline::spinner;
 bool Cmdline::vtlb;
 bool Cmdline::nodl;
+bool Cmdline::nomwait;
 bool Cmdline::nopcid;
 bool Cmdline::novga;
 bool Cmdline::novpid;
@@ -41,6 +42,7 @@ struct Cmdline::param_map Cmdline::map[] INITDATA =
     { "spinner",    &Cmdline::spinner   },
     { "vtlb",       &Cmdline::vtlb      },
     { "nodl",       &Cmdline::nodl      },
+    { "nomwait",    &Cmdline::nomwait   },
     { "nopcid",     &Cmdline::nopcid    },
     { "novga",      &Cmdline::novga     },
     { "novpid",     &Cmdline::novpid    },
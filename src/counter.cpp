@@ -18,6 +18,7 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "bits.hpp"
 #include "counter.hpp"
 #include "stdio.hpp"
 #include "x86.hpp"
@@ -26,6 +27,7 @@ unsigned    Counter::ipi[NUM_IPI];
 unsigned    Counter::lvt[NUM_LVT];
 unsigned    Counter::gsi[NUM_GSI];
 unsigned    Counter::exc[NUM_EXC];
+unsigned    Counter::sched_link[NUM_LNK];
 unsigned    Counter::vmi[NUM_VMI];
 unsigned    Counter::vtlb_gpf;
 unsigned    Counter::vtlb_hpf;
@@ -33,10 +35,31 @@ unsigned    Counter::vtlb_fill;
 unsigned    Counter::vtlb_flush;
 unsigned    Counter::schedule;
 unsigned    Counter::helping;
+unsigned    Counter::help_yield;
+unsigned    Counter::ipc_call;
+unsigned    Counter::ipc_reply;
+unsigned    Counter::ipc_fwd;
+unsigned    Counter::ipc_xcpu;
+unsigned    Counter::timer_set;
+unsigned    Counter::rrq_coalesced;
+unsigned    Counter::rrq_polled;
+unsigned    Counter::rrq_wakeup;
+unsigned    Counter::zero_hit;
+unsigned    Counter::zero_miss;
 uint64      Counter::cycles_idle;
+uint64      Counter::cycles_cst[NUM_CST];
+uint64      Counter::cycles_link[NUM_LNK];
+uint64      Counter::cycles_sched;
+uint64      Counter::cycles_call;
+uint64      Counter::cycles_reply;
+uint64      Counter::cycles_xcpu;
+uint64      Counter::cycles_wake;
+uint64      Counter::cycles_zero;
 
 void Counter::dump()
 {
+    uint32 dummy;
+
     trace (0, "TIME: %16llu", rdtsc());
     trace (0, "IDLE: %16llu", Counter::cycles_idle);
     trace (0, "VGPF: %16u", Counter::vtlb_gpf);
@@ -44,9 +67,39 @@ void Counter::dump()
     trace (0, "VFIL: %16u", Counter::vtlb_fill);
     trace (0, "VFLU: %16u", Counter::vtlb_flush);
     trace (0, "SCHD: %16u", Counter::schedule);
+    trace (0, "SCYC: %16llu", Counter::schedule ? div64 (Counter::cycles_sched, Counter::schedule, &dummy) : 0);
     trace (0, "HELP: %16u", Counter::helping);
+    trace (0, "HLPY: %16u", Counter::help_yield);
+    trace (0, "CALL: %16u", Counter::ipc_call);
+    trace (0, "CCYC: %16llu", Counter::ipc_call ? div64 (Counter::cycles_call, Counter::ipc_call, &dummy) : 0);
+    trace (0, "REPL: %16u", Counter::ipc_reply);
+    trace (0, "RCYC: %16llu", Counter::ipc_reply ? div64 (Counter::cycles_reply, Counter::ipc_reply, &dummy) : 0);
+    trace (0, "IFWD: %16u", Counter::ipc_fwd);
+    trace (0, "XCPU: %16u", Counter::ipc_xcpu);
+    trace (0, "XCYC: %16llu", Counter::ipc_xcpu ? div64 (Counter::cycles_xcpu, Counter::ipc_xcpu, &dummy) : 0);
+    trace (0, "TSET: %16u", Counter::timer_set);
+    trace (0, "RRQC: %16u", Counter::rrq_coalesced);
+    trace (0, "RRQP: %16u", Counter::rrq_polled);
+    trace (0, "WAKE: %16llu", Counter::rrq_wakeup ? div64 (Counter::cycles_wake, Counter::rrq_wakeup, &dummy) : 0);
+    trace (0, "ZHIT: %16u", Counter::zero_hit);
+    trace (0, "ZMIS: %16u", Counter::zero_miss);
+    trace (0, "ZCYC: %16llu", Counter::zero_miss ? div64 (Counter::cycles_zero, Counter::zero_miss, &dummy) : 0);
+
+    Counter::vtlb_gpf = Counter::vtlb_hpf = Counter::vtlb_fill = Counter::vtlb_flush = Counter::schedule = Counter::helping = Counter::help_yield = Counter::ipc_call = Counter::ipc_reply = Counter::ipc_fwd = Counter::ipc_xcpu = Counter::timer_set = Counter::rrq_coalesced = Counter::rrq_polled = Counter::rrq_wakeup = Counter::zero_hit = Counter::zero_miss = 0;
+    Counter::cycles_sched = Counter::cycles_call = Counter::cycles_reply = Counter::cycles_wake = Counter::cycles_xcpu = Counter::cycles_zero = 0;
 
-    Counter::vtlb_gpf = Counter::vtlb_hpf = Counter::vtlb_fill = Counter::vtlb_flush = Counter::schedule = Counter::helping = 0;
+    for (unsigned i = 0; i < sizeof (Counter::cycles_cst) / sizeof (*Counter::cycles_cst); i++)
+        if (Counter::cycles_cst[i]) {
+            trace (0, "CST %#4x: %12llu", i, Counter::cycles_cst[i]);
+            Counter::cycles_cst[i] = 0;
+        }
+
+    for (unsigned i = 0; i < sizeof (Counter::sched_link) / sizeof (*Counter::sched_link); i++)
+        if (Counter::sched_link[i]) {
+            trace (0, "LNK %#4x: %12llu", i, div64 (Counter::cycles_link[i], Counter::sched_link[i], &dummy));
+            Counter::sched_link[i] = 0;
+            Counter::cycles_link[i] = 0;
+        }
 
     for (unsigned i = 0; i < sizeof (Counter::ipi) / sizeof (*Counter::ipi); i++)
         if (Counter::ipi[i]) {
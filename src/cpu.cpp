@@ -65,7 +65,9 @@ unsigned    Cpu::row;
 
 uint32      Cpu::name[12];
 uint32      Cpu::features[6];
+uint32      Cpu::cstates;
 bool        Cpu::bsp;
+bool        Cpu::ready;
 
 void Cpu::check_features()
 {
@@ -94,7 +96,10 @@ void Cpu::check_features()
             cpuid (0x7, 0, eax, features[3], ecx, edx);
         case 0x6:
             cpuid (0x6, features[2], ebx, ecx, edx);
-        case 0x4 ... 0x5:
+        case 0x5:
+            cpuid (0x5, eax, ebx, ecx, edx);
+            cstates = ecx & 1 ? edx : 0;
+        case 0x4:
             cpuid (0x4, 0, eax, ebx, ecx, edx);
             cpp = (eax >> 26 & 0x3f) + 1;
         case 0x1 ... 0x3:
@@ -129,6 +134,9 @@ void Cpu::check_features()
     if (feature (FEAT_CMP_LEGACY))
         cpp = tpp;
 
+    if (!feature (FEAT_MONITOR) || Cmdline::nomwait)
+        cstates = 0;
+
     unsigned tpc = tpp / cpp;
     unsigned long t_bits = bit_scan_reverse (tpc - 1) + 1;
     unsigned long c_bits = bit_scan_reverse (cpp - 1) + 1;
@@ -143,6 +151,26 @@ void Cpu::check_features()
             Msr::write (Msr::AMD_IPMR, Msr::read<uint32>(Msr::AMD_IPMR) & ~(3ul << 27));
 }
 
+unsigned Cpu::cstate (uint64 cycles, bool timer)
+{
+    // Target residency in us per MWAIT C-state, 0 is hlt
+    static unsigned const residency[NUM_CST] = { 0, 2, 20, 100, 400, 1000, 2000, 5000 };
+
+    unsigned c = 0;
+
+    for (unsigned n = 1; n < NUM_CST; n++) {
+
+        // Without ARAT the LAPIC timer stops in C-states deeper than C1
+        if (n > 1 && timer && !feature (FEAT_ARAT))
+            break;
+
+        if (cstates >> 4 * n & 0xf && cycles >= static_cast<uint64>(Lapic::freq_tsc / 1000) * residency[n])
+            c = n;
+    }
+
+    return c;
+}
+
 void Cpu::setup_thermal()
 {
     Msr::write (Msr::IA32_THERM_INTERRUPT, 0x10);
@@ -219,5 +247,7 @@ void Cpu::init()
 
     Hip::add_cpu();
 
+    ready = true;
+
     boot_lock++;
 }
@@ -26,6 +26,7 @@
 #include "rcu.hpp"
 #include "stdio.hpp"
 #include "svm.hpp"
+#include "timeout_budget.hpp"
 #include "vmx.hpp"
 #include "vtlb.hpp"
 
@@ -35,12 +36,12 @@ Slab_cache Ec::cache (sizeof (Ec), 32);
 Ec *Ec::current, *Ec::fpowner;
 
 // Constructors
-Ec::Ec (Pd *own, void (*f)(), unsigned c) : Kobject (EC, static_cast<Space_obj *>(own)), cont (f), utcb (nullptr), pd (own), prev (nullptr), next (nullptr), cpu (static_cast<uint16>(c)), glb (true), evt (0), timeout (this)
+Ec::Ec (Pd *own, void (*f)(), unsigned c) : Kobject (EC, static_cast<Space_obj *>(own)), cont (f), utcb (nullptr), pd (own), rsc (nullptr), prev (nullptr), next (nullptr), cpu (static_cast<uint16>(c)), glb (true), evt (0), timeout (this), mc_cnt (0), scs (0)
 {
     trace (TRACE_SYSCALL, "EC:%p created (PD:%p Kernel)", this, own);
 }
 
-Ec::Ec (Pd *own, mword sel, Pd *p, void (*f)(), unsigned c, unsigned e, mword u, mword s) : Kobject (EC, static_cast<Space_obj *>(own), sel, 0xd), cont (f), pd (p), prev (nullptr), next (nullptr), cpu (static_cast<uint16>(c)), glb (!!f), evt (e), timeout (this)
+Ec::Ec (Pd *own, mword sel, Pd *p, void (*f)(), unsigned c, unsigned e, mword u, mword s) : Kobject (EC, static_cast<Space_obj *>(own), sel, 0xd), cont (f), pd (p), rsc (nullptr), prev (nullptr), next (nullptr), cpu (static_cast<uint16>(c)), glb (!!f), evt (e), timeout (this), mc_cnt (0), scs (0)
 {
     // Make sure we have a PTAB for this CPU in the PD
     pd->Space_mem::init (c);
@@ -93,6 +94,19 @@ Ec::Ec (Pd *own, mword sel, Pd *p, void (*f)(), unsigned c, unsigned e, mword u,
     }
 }
 
+void Ec::migrate (unsigned c)
+{
+    if (fpowner == this) {
+        Fpu::enable();
+        save_fpu();
+        fpowner = nullptr;
+    }
+
+    pd->Space_mem::init (c);
+
+    cpu = static_cast<uint16>(c);
+}
+
 void Ec::handle_hazard (mword hzd, void (*func)())
 {
     if (hzd & HZD_RCU)
@@ -241,17 +255,46 @@ void Ec::ret_user_vmrun()
 
 void Ec::idle()
 {
+    uint64 avg = ~0ULL >> 1;
+
     for (;;) {
 
         mword hzd = Cpu::hazard & (HZD_RCU | HZD_SCHED);
         if (EXPECT_FALSE (hzd))
             handle_hazard (hzd, idle);
 
+        Sc::balance();
+
+        Buddy::allocator.prezero();
+
+        bool tickless = Rcu::idle_enter();
+
+        if (EXPECT_FALSE (Cpu::hazard & (HZD_RCU | HZD_SCHED))) {
+            Rcu::idle_leave();
+            continue;
+        }
+
+        // The idle SC needs no budget unless RCU work is pending locally
+        if (tickless) {
+            Timeout_budget::budget.dequeue();
+            if (!Timeout::heap)
+                Timeout::disarm();
+        } else if (!Timeout_budget::budget.active())
+            Timeout_budget::budget.enqueue (rdtsc() + Sc::current->budget);
+
         uint64 t1 = rdtsc();
-        asm volatile ("sti; hlt; cli" : : : "memory");
+        uint64 d = Timeout::earliest();
+        unsigned c = Cpu::cstate (min (d > t1 ? d - t1 : 0, avg << 1), Timeout::heap);
+
+        Sc::wait (c);
         uint64 t2 = rdtsc();
 
+        Rcu::idle_leave();
+
+        avg += ((t2 - t1) >> 3) - (avg >> 3);
+
         Counter::cycles_idle += t2 - t1;
+        Counter::cycles_cst[c] += t2 - t1;
     }
 }
 
@@ -325,7 +368,9 @@ void Ec::die (char const *reason, Exc_regs *r)
 
     Ec *ec = current->rcap;
 
-    if (ec)
+    if (ec && ec->cont == xcpu_reply<Sys_regs::SUCCESS>)
+        ec->cont = xcpu_reply<Sys_regs::COM_ABT>;
+    else if (ec)
         ec->cont = ec->cont == ret_user_sysexit ? static_cast<void (*)()>(sys_finish<Sys_regs::COM_ABT>) : dead;
 
     reply (dead);
@@ -0,0 +1,130 @@
+/*
+ * Execution Context
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include "ec.hpp"
+#include "pt.hpp"
+#include "sc.hpp"
+#include "utcb.hpp"
+
+Ec::Xq Ec::xq[NUM_CPU];
+
+void Ec::xcpu_init()
+{
+    Xq *q = xq + Cpu::id;
+
+    q->proxy = new Ec (&Pd::kern, xcpu_proxy, Cpu::id);
+    q->sc    = new Sc (&Pd::kern, Cpu::id, q->proxy, Cpu::id, q->prio = Sc::default_prio, Sc::default_quantum);
+    q->sc->remote_enqueue();
+}
+
+void Ec::xcpu_call (Pt *pt)
+{
+    Ec *ec = current;
+    Xq *q = xq + pt->ec->cpu;
+
+    if (EXPECT_FALSE (ec->utcb->tcnt()))
+        sys_finish<Sys_regs::BAD_PAR>();
+
+    ec->xpt  = pt;
+    ec->xtsc = rdtsc();
+    ec->cont = nullptr;
+
+    bool wake;
+
+    {   Lock_guard <Spinlock> guard (q->lock);
+
+        q->queue.enqueue (ec);
+
+        // The proxy runs at the highest priority of the callers it serves
+        if (Sc::current->prio > q->prio)
+            q->sc->set_qpd (q->prio = Sc::current->prio, Sc::default_quantum);
+
+        wake = q->idle;
+        q->idle = false;
+    }
+
+    if (wake)
+        q->proxy->release (xcpu_proxy);
+
+    // Stays blocked until the proxy has delivered the reply
+    ec->block_sc();
+
+    ret_user_sysexit();
+}
+
+void Ec::xcpu_proxy()
+{
+    Xq *q = xq + Cpu::id;
+
+    // Every way back into the proxy drops the borrowed UTCB
+    current->utcb = nullptr;
+
+    while (!q->cur) {
+
+        {   Lock_guard <Spinlock> guard (q->lock);
+
+            if (q->queue.dequeue (q->cur = q->queue.head()))
+                break;
+
+            if (q->prio != Sc::default_prio)
+                q->sc->set_qpd (q->prio = Sc::default_prio, Sc::default_quantum);
+
+            q->idle = true;
+            current->cont = nullptr;
+        }
+
+        current->block_sc();
+    }
+
+    Ec *c = q->cur;
+    Pt *pt = c->xpt;
+    Ec *ec = pt->ec;
+
+    if (EXPECT_TRUE (!ec->cont)) {
+        c->utcb->save (ec->utcb);
+        current->utcb = c->utcb;
+        current->cont = xcpu_reply<Sys_regs::SUCCESS>;
+        current->set_partner (ec);
+        ec->cont = ret_user_sysexit;
+        ec->regs.set_pt (pt->id);
+        ec->regs.set_ip (pt->ip);
+        ec->make_current();
+    }
+
+    ec->help (xcpu_proxy);
+
+    xcpu_reply<Sys_regs::COM_ABT>();
+}
+
+template <Sys_regs::Status S>
+void Ec::xcpu_reply()
+{
+    Xq *q = xq + Cpu::id;
+    Ec *c = q->cur;
+
+    Counter::ipc_xcpu++;
+    Counter::cycles_xcpu += rdtsc() - c->xtsc;
+
+    q->cur = nullptr;
+    current->utcb = nullptr;
+
+    c->regs.set_status (S);
+    c->release (ret_user_sysexit);
+
+    xcpu_proxy();
+}
+
+template void Ec::xcpu_reply<Sys_regs::SUCCESS>();
+template void Ec::xcpu_reply<Sys_regs::COM_ABT>();
@@ -20,16 +20,20 @@
  */
 
 #include "acpi.hpp"
+#include "barrier.hpp"
 #include "dmar.hpp"
 #include "gsi.hpp"
 #include "ioapic.hpp"
 #include "keyb.hpp"
 #include "lapic.hpp"
+#include "lock_guard.hpp"
 #include "sm.hpp"
 #include "vectors.hpp"
+#include "x86.hpp"
 
 Gsi         Gsi::gsi_table[NUM_GSI];
 unsigned    Gsi::irq_table[NUM_IRQ];
+Spinlock    Gsi::lock;
 
 void Gsi::setup()
 {
@@ -86,6 +90,45 @@ void Gsi::unmask (unsigned gsi)
         ioapic->set_irt (gsi, 0U << 16 | gsi_table[gsi].irt);
 }
 
+void Gsi::unmask (Sm *ntf, mword bits)
+{
+    for (unsigned gsi = 0; gsi < NUM_GSI; gsi++)
+        if (gsi_table[gsi].ntf == ntf && gsi_table[gsi].bits & bits && gsi_table[gsi].trg)
+            unmask (gsi);
+}
+
+void Gsi::bind (unsigned gsi, Sm *ntf, mword bits)
+{
+    Lock_guard <Spinlock> guard (lock);
+
+    Sm *old = gsi_table[gsi].ntf;
+
+    // Odd while ntf and bits change, see Gsi::vector
+    ACCESS_ONCE (gsi_table[gsi].seq)++;
+    barrier();
+
+    gsi_table[gsi].ntf = nullptr;
+
+    // Drop the old bits unless another GSI still signals them
+    if (old) {
+        mword keep = 0;
+        for (unsigned i = 0; i < NUM_GSI; i++)
+            if (gsi_table[i].ntf == old)
+                keep |= gsi_table[i].bits;
+        Atomic::clr_mask (old->gsi, gsi_table[gsi].bits & ~keep);
+    }
+
+    if (ntf) {
+        Atomic::set_mask (ntf->gsi, bits);
+        gsi_table[gsi].bits = bits;
+    }
+
+    gsi_table[gsi].ntf = ntf;
+
+    barrier();
+    ACCESS_ONCE (gsi_table[gsi].seq)++;
+}
+
 void Gsi::vector (unsigned vector)
 {
     unsigned gsi = vector - VEC_GSI;
@@ -101,7 +144,21 @@ void Gsi::vector (unsigned vector)
 
     Lapic::eoi();
 
-    gsi_table[gsi].sm->up();
+    Sm *ntf; mword bits; unsigned seq;
+
+    do {
+        while ((seq = ACCESS_ONCE (gsi_table[gsi].seq)) & 1)
+            pause();
+        barrier();
+        ntf  = ACCESS_ONCE (gsi_table[gsi].ntf);
+        bits = ACCESS_ONCE (gsi_table[gsi].bits);
+        barrier();
+    } while (EXPECT_FALSE (seq != ACCESS_ONCE (gsi_table[gsi].seq)));
+
+    if (ntf)
+        ntf->signal (bits);
+    else
+        gsi_table[gsi].sm->up();
 
     Counter::print<1,16> (++Counter::gsi[gsi], Console_vga::Color (Console_vga::COLOR_LIGHT_YELLOW - gsi / 64), SPN_GSI + gsi % 64);
 }
@@ -113,6 +113,13 @@ void Hip::add_mhv (Hip_mem *&mem)
     mem->size = reinterpret_cast<mword>(&LINK_E) - mem->addr;
     mem->type = Hip_mem::HYPERVISOR;
     mem++;
+
+    // Read-only clock page, the root PD maps it with a host delegation
+    mem->addr = reinterpret_cast<mword>(&FRAME_C);
+    mem->size = PAGE_SIZE;
+    mem->type = Hip_mem::CLOCK;
+    mem->aux  = 0;
+    mem++;
 }
 
 void Hip::add_cpu()
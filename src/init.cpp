@@ -52,9 +52,10 @@ mword kern_ptab_setup()
 extern "C" INIT REGPARM (1)
 void init (mword mbi)
 {
-    // Setup 0-page and 1-page
+    // Setup 0-page, 1-page and clock page
     memset (reinterpret_cast<void *>(&PAGE_0),  0,  PAGE_SIZE);
     memset (reinterpret_cast<void *>(&PAGE_1), ~0u, PAGE_SIZE);
+    memset (reinterpret_cast<void *>(&PAGE_C),  0,  PAGE_SIZE);
 
     for (void (**func)() = &CTORS_G; func != &CTORS_E; (*func++)()) ;
 
@@ -42,6 +42,9 @@ Pd::Pd (Pd *own) : Kobject (PD, static_cast<Space_obj *>(own))
     // HIP
     Space_mem::insert_root (reinterpret_cast<mword>(&FRAME_H), reinterpret_cast<mword>(&FRAME_H) + PAGE_SIZE, 1);
 
+    // Clock
+    Space_mem::insert_root (reinterpret_cast<mword>(&FRAME_C), reinterpret_cast<mword>(&FRAME_C) + PAGE_SIZE, 1);
+
     // I/O Ports
     Space_pio::addreg (0, 1UL << 16, 7);
 }
@@ -242,7 +245,56 @@ void Pd::rev_crd (Crd crd, bool self)
     Cpu::preempt_disable();
 }
 
-void Pd::xfer_items (Pd *src, Crd xlt, Crd del, Xfer *s, Xfer *d, unsigned long ti)
+mword Pd::covered (Space_mem *s, mword base, mword ord)
+{
+    Mdb *mdb; mword n = 0;
+    for (mword addr = base; (mdb = s->tree_lookup (addr, true)); addr = mdb->node_base + (1UL << mdb->node_order)) {
+
+        mword o, b = base;
+        if ((o = clamp (mdb->node_base, b, mdb->node_order, ord)) == ~0UL)
+            break;
+
+        n += 1UL << o;
+    }
+
+    return n;
+}
+
+/*
+ * Transient grants are ordinary MDB children of the sender's mappings
+ * and last until the receiver replies. The sender range must be fully
+ * mapped and the receive window empty, so the revoke on reply covers
+ * exactly the nodes created here.
+ */
+void Pd::tmp_crd (Pd *pd, Crd del, Crd &crd, mword hot)
+{
+    mword a = crd.attr() & del.attr(), sb = crd.base(), rb = del.base();
+
+    if (EXPECT_FALSE (crd.type() != Crd::MEM || del.type() != Crd::MEM || !a)) {
+        crd = Crd (0);
+        return;
+    }
+
+    mword o = min (clamp (sb, rb, crd.order(), del.order(), hot), tmp_order);
+
+    if (EXPECT_FALSE (max (sb, rb) + (1UL << o) > USER_ADDR >> PAGE_BITS || covered (this, rb, o) || covered (pd, sb, o) != 1UL << o)) {
+        crd = Crd (0);
+        return;
+    }
+
+    trace (TRACE_DEL, "TMP MEM PD:%p->%p SB:%#010lx RB:%#010lx O:%#04lx A:%#lx", pd, this, sb, rb, o, a);
+
+    delegate<Space_mem>(pd, sb, rb, o, a);
+
+    crd = Crd (Crd::MEM, rb, o, a);
+}
+
+void Pd::rev_tmp (Crd crd)
+{
+    rev_crd (crd, true);
+}
+
+void Pd::xfer_items (Pd *src, Crd xlt, Crd del, Xfer *s, Xfer *d, unsigned long ti, Crd *tmp)
 {
     for (Crd crd; ti--; s--) {
 
@@ -255,6 +307,14 @@ void Pd::xfer_items (Pd *src, Crd xlt, Crd del, Xfer *s, Xfer *d, unsigned long
                 break;
 
             case 1:
+                if (EXPECT_FALSE (s->flags() & 0x2)) {
+                    if (tmp && !tmp->type()) {
+                        tmp_crd (src, del, crd, s->hotspot());
+                        *tmp = crd;
+                    } else
+                        crd = Crd (0);
+                    break;
+                }
                 del_crd (src == &root && s->flags() & 0x800 ? &kern : src, del, crd, s->flags() >> 9 & 3, s->hotspot());
                 break;
         };
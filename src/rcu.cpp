@@ -24,11 +24,14 @@
 #include "cpu.hpp"
 #include "hazards.hpp"
 #include "initprio.hpp"
+#include "lapic.hpp"
 #include "rcu.hpp"
 #include "stdio.hpp"
+#include "vectors.hpp"
 
 mword   Rcu::state = RCU_CMP;
 mword   Rcu::count;
+Cpuset  Rcu::idle;
 
 mword   Rcu::l_batch;
 mword   Rcu::c_batch;
@@ -60,7 +63,12 @@ void Rcu::start_batch (State s)
 
     barrier();
 
-    state++;
+    Atomic::add (state, 1UL);
+
+    // Tickless idle CPUs must observe the new batch
+    for (unsigned cpu = 0; cpu < NUM_CPU; cpu++)
+        if (idle.chk (cpu) && cpu != Cpu::id)
+            Lapic::send_ipi (cpu, VEC_IPI_RRQ);
 }
 
 void Rcu::quiet()
@@ -93,3 +101,12 @@ void Rcu::update()
     if (done.head)
         invoke_batch();
 }
+
+bool Rcu::idle_enter()
+{
+    idle.set (Cpu::id);
+
+    update();
+
+    return !(Cpu::hazard & HZD_RCU) && !next.head && !curr.head && !done.head;
+}
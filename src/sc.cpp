@@ -20,7 +20,9 @@
  */
 
 #include "ec.hpp"
+#include "hip.hpp"
 #include "lapic.hpp"
+#include "lock_guard.hpp"
 #include "stdio.hpp"
 #include "timeout_budget.hpp"
 #include "vectors.hpp"
@@ -34,47 +36,93 @@ Sc::Rq Sc::rq;
 Sc *        Sc::current;
 unsigned    Sc::ctr_link;
 unsigned    Sc::ctr_loop;
+Sc *        Sc::donee;
+uint64      Sc::donee_tsc;
 
 Sc *Sc::list[Sc::priorities];
 
-unsigned Sc::prio_top;
+mword Sc::prio_map[Sc::priorities / Sc::prio_bits];
 
-Sc::Sc (Pd *own, mword sel, Ec *e) : Kobject (SC, static_cast<Space_obj *>(own), sel, 0x1), ec (e), cpu (static_cast<unsigned>(sel)), prio (0), budget (Lapic::freq_tsc * 1000), left (0), prev (nullptr), next (nullptr)
+mword Sc::prio_sum;
+
+Sc::Sc (Pd *own, mword sel, Ec *e) : Kobject (SC, static_cast<Space_obj *>(own), sel, 0x1), ec (e), cpu (static_cast<unsigned>(sel)), prio (0), base (0), budget (Lapic::freq_tsc * 1000), period (0), deadline (0), mig (false), hist_wait(), hist_run(), left (0), prev (nullptr), next (nullptr), dl (0), util (0), upd (0)
 {
+    e->bind_sc();
+
     trace (TRACE_SYSCALL, "SC:%p created (PD:%p Kernel)", this, own);
 }
 
-Sc::Sc (Pd *own, mword sel, Ec *e, unsigned c, unsigned p, unsigned q) : Kobject (SC, static_cast<Space_obj *>(own), sel, 0x1), ec (e), cpu (c), prio (p), budget (Lapic::freq_tsc / 1000 * q), left (0), prev (nullptr), next (nullptr)
+Sc::Sc (Pd *own, mword sel, Ec *e, unsigned c, unsigned p, unsigned q, bool m, unsigned per, unsigned d) : Kobject (SC, static_cast<Space_obj *>(own), sel, own == &Pd::kern ? 0x1 : 0xf), ec (e), cpu (c), prio (p), base (p), budget (Lapic::freq_tsc / 1000 * q), period (static_cast<uint64>(Lapic::freq_tsc / 1000) * per), deadline (static_cast<uint64>(Lapic::freq_tsc / 1000) * d), mig (m), hist_wait(), hist_run(), left (0), prev (nullptr), next (nullptr), dl (0), util (0), upd (0)
+{
+    uint32 dummy;
+
+    if (per)
+        util = static_cast<unsigned>(div64 (static_cast<uint64>(q) << 16, per, &dummy));
+
+    e->bind_sc();
+
+    trace (TRACE_SYSCALL, "SC:%p created (EC:%p CPU:%#x P:%#x Q:%#x T:%#x D:%#x%s)", this, e, c, p, q, per, d, m ? " MIG" : "");
+}
+
+Sc::~Sc()
+{
+    ec->unbind_sc();
+}
+
+void Sc::cbs_update (uint64 t)
 {
-    trace (TRACE_SYSCALL, "SC:%p created (EC:%p CPU:%#x P:%#x Q:%#x)", this, e, c, p, q);
+    // Budget exhausted before the deadline: postpone the deadline by one period
+    if (!left && dl > t) {
+        dl += period;
+        left = budget;
+    }
+
+    // Deadline passed or remaining budget exceeds the reserved bandwidth
+    else if (dl <= t || (left << 16) > (dl - t) * util) {
+        dl = t + deadline;
+        left = budget;
+    }
 }
 
-void Sc::ready_enqueue (uint64 t)
+void Sc::ready_enqueue (uint64 t, bool head)
 {
     assert (prio < priorities);
     assert (cpu == Cpu::id);
 
-    if (prio > prio_top)
-        prio_top = prio;
+    if (EXPECT_FALSE (period))
+        cbs_update (t);
 
-    if (!list[prio])
+    if (!list[prio]) {
         list[prio] = prev = next = this;
-    else {
-        next = list[prio];
-        prev = list[prio]->prev;
+        prio_set (prio);
+    } else {
+        Sc *h = list[prio], *pos = h;
+
+        // Deadline SCs precede round-robin SCs and are kept in deadline order
+        if (EXPECT_FALSE (period || (h->period && left)))
+            while (!before (pos) && (pos = pos->next) != h) ;
+
+        next = pos;
+        prev = pos->prev;
         next->prev = prev->next = this;
-        if (left)
+        // A yield only moves round-robin SCs to the tail
+        if (pos == h && (head || period) && before (h))
             list[prio] = this;
     }
 
-    trace (TRACE_SCHEDULE, "ENQ:%p (%llu) PRIO:%#x TOP:%#x %s", this, left, prio, prio_top, prio > current->prio ? "reschedule" : "");
+    trace (TRACE_SCHEDULE, "ENQ:%p (%llu) PRIO:%#x TOP:%#x %s", this, left, prio, prio_top(), prio > current->prio ? "reschedule" : "");
 
-    if (prio > current->prio || (this != current && prio == current->prio && left))
+    if (prio > current->prio || (this != current && prio == current->prio && before (current)))
         Cpu::hazard |= HZD_SCHED;
 
     if (!left)
         left = budget;
 
+    rq.ready++;
+
+    if (mig)
+        rq.ready_mig++;
+
     tsc = t;
 }
 
@@ -84,24 +132,26 @@ void Sc::ready_dequeue (uint64 t)
     assert (cpu == Cpu::id);
     assert (prev && next);
 
-    if (list[prio] == this)
-        list[prio] = next == this ? nullptr : next;
+    if (list[prio] == this && !(list[prio] = next == this ? nullptr : next))
+        prio_clr (prio);
 
     next->prev = prev;
     prev->next = next;
     prev = next = nullptr;
 
-    while (!list[prio_top] && prio_top)
-        prio_top--;
+    trace (TRACE_SCHEDULE, "DEQ:%p (%llu) PRIO:%#x TOP:%#x", this, left, prio, prio_top());
+
+    rq.ready--;
 
-    trace (TRACE_SCHEDULE, "DEQ:%p (%llu) PRIO:%#x TOP:%#x", this, left, prio, prio_top);
+    if (mig)
+        rq.ready_mig--;
 
     ec->add_tsc_offset (tsc - t);
 
     tsc = t;
 }
 
-void Sc::schedule (bool suspend)
+void Sc::schedule (bool suspend, bool yield)
 {
     Counter::print<1,16> (++Counter::schedule, Console_vga::COLOR_LIGHT_CYAN, SPN_SCH);
 
@@ -112,14 +162,22 @@ void Sc::schedule (bool suspend)
     uint64 d = Timeout_budget::budget.dequeue();
 
     current->time += t - current->tsc;
+    hist_add (current->hist_run, t - current->tsc);
+
+    settle (t);
+
+    // Inherited priority lasts for one dispatch
+    current->prio = current->base;
     current->left = d > t ? d - t : 0;
 
+    handoff();
+
     Cpu::hazard &= ~HZD_SCHED;
 
-    if (EXPECT_TRUE (!suspend))
-        current->ready_enqueue (t);
+    if (EXPECT_TRUE (!suspend) && !(EXPECT_FALSE (current->upd) && current->update()))
+        current->ready_enqueue (t, !yield);
 
-    Sc *sc = list[prio_top];
+    Sc *sc = list[prio_top()];
     assert (sc);
 
     Timeout_budget::budget.enqueue (t + sc->left);
@@ -127,28 +185,45 @@ void Sc::schedule (bool suspend)
     ctr_loop = 0;
 
     current = sc;
+    hist_add (sc->hist_wait, t - sc->tsc);
     sc->ready_dequeue (t);
+
+    // Scan the remote run queues at most once per millisecond
+    if (t - rq.stl_tsc >= Lapic::freq_tsc) {
+        rq.stl_tsc = t;
+        balance();
+    }
+
+    unsigned l = min (sc->ec->links(), static_cast<unsigned>(NUM_LNK - 1));
+    uint64 c = rdtsc() - t;
+
+    Counter::cycles_sched += c;
+    Counter::cycles_link[l] += c;
+    Counter::sched_link[l]++;
+
     sc->ec->activate();
 }
 
 void Sc::remote_enqueue()
 {
-    if (Cpu::id == cpu)
+    if (Cpu::id == cpu) {
         ready_enqueue (rdtsc());
+        defer_update();
+    }
 
     else {
         Sc::Rq *r = remote (cpu);
 
-        Lock_guard <Spinlock> guard (r->lock);
+        wake = rdtsc();
 
-        if (r->queue) {
-            next = r->queue;
-            prev = r->queue->prev;
-            next->prev = prev->next = this;
-        } else {
-            r->queue = prev = next = this;
+        // Only the producer that found the queue empty needs to kick the consumer,
+        // a consumer polling in MWAIT is woken by the write to the queue itself
+        if (!r->queue.enqueue (this))
+            Counter::rrq_coalesced++;
+        else if (ACCESS_ONCE (r->poll))
+            Counter::rrq_polled++;
+        else
             Lapic::send_ipi (cpu, VEC_IPI_RRQ);
-        }
     }
 }
 
@@ -156,21 +231,125 @@ void Sc::rrq_handler()
 {
     uint64 t = rdtsc();
 
-    Lock_guard <Spinlock> guard (rq.lock);
+    Sc *fifo = rq.queue.dequeue_all();
+
+    for (Sc *n; fifo; fifo = n) {
+        n = fifo->next;
+        Counter::rrq_wakeup++;
+        Counter::cycles_wake += t - fifo->wake;
+        fifo->ready_enqueue (t);
+        fifo->defer_update();
+    }
+}
+
+void Sc::wait (unsigned c)
+{
+    if (!c) {
+        Cpu::halt();
+        return;
+    }
+
+    Atomic::exchange (rq.poll, 1U);
 
-    for (Sc *ptr = rq.queue; ptr; ) {
+    Cpu::monitor (&rq);
 
-        ptr->next->prev = ptr->prev;
-        ptr->prev->next = ptr->next;
+    if (rq.queue.empty())
+        Cpu::mwait (c);
 
-        Sc *sc = ptr;
+    Atomic::exchange (rq.poll, 0U);
 
-        ptr = ptr->next == ptr ? nullptr : ptr->next;
+    if (!rq.queue.empty())
+        rrq_handler();
+}
+
+/*
+ * Migrating an EC allocates and must not happen in interrupt context,
+ * so the IPI only forces a reschedule and schedule does the work.
+ */
+void Sc::stl_handler()
+{
+    Cpu::hazard |= HZD_SCHED;
+}
+
+void Sc::handoff()
+{
+    if (EXPECT_FALSE (ACCESS_ONCE (rq.upd)) && Atomic::exchange (rq.upd, 0U))
+        update_ready();
+
+    if (EXPECT_TRUE (!ACCESS_ONCE (rq.stl)) || !Atomic::exchange (rq.stl, 0U))
+        return;
+
+    for (unsigned c = 0; c < NUM_CPU; c++) {
 
-        sc->ready_enqueue (t);
+        if (!rq.steal.chk (c))
+            continue;
+
+        rq.steal.clr (c);
+
+        Sc *sc = steal_candidate();
+        if (!sc)
+            continue;
+
+        trace (TRACE_SCHEDULE, "STL:%p CPU:%#x->%#x", sc, sc->cpu, c);
+
+        sc->ready_dequeue (rdtsc());
+        sc->ec->migrate (c);
+        sc->cpu = c;
+        sc->remote_enqueue();
     }
+}
 
-    rq.queue = nullptr;
+Sc *Sc::steal_candidate()
+{
+    for (unsigned w = priorities / prio_bits; w--; )
+        for (mword m = prio_map[w]; m; ) {
+
+            unsigned long b = bit_scan_reverse (m);
+            m &= ~(1UL << b);
+
+            Sc *h = list[w * prio_bits + b], *s = h;
+
+            do if (s->mig && !s->ec->pinned()) return s; while ((s = s->next) != h);
+        }
+
+    return nullptr;
+}
+
+void Sc::steal()
+{
+    Hip_cpu const *l = Hip::cpu_topo (Cpu::id);
+
+    unsigned victim = ~0U, dist = ~0U, load = 0;
+
+    // Only the local run queues count migratable SCs; nothing shared is
+    // written in the enqueue and dequeue paths
+    for (unsigned c = 0; c < NUM_CPU; c++) {
+
+        if (c == Cpu::id || !Hip::cpu_online (c))
+            continue;
+
+        Rq *r = remote (c);
+
+        unsigned ready = ACCESS_ONCE (r->ready);
+
+        if (!ACCESS_ONCE (r->ready_mig) || ready <= rq.ready + 1)
+            continue;
+
+        // Prefer SMT siblings, then cores in the same package
+        Hip_cpu const *h = Hip::cpu_topo (c);
+        unsigned d = h->package != l->package ? 2 : h->core != l->core;
+
+        if (d < dist || (d == dist && ready > load)) {
+            victim = c;
+            dist = d;
+            load = ready;
+        }
+    }
+
+    if (victim != ~0U && remote (victim)->steal.set (Cpu::id)) {
+        Atomic::exchange (remote (victim)->stl, 1U);
+        Lapic::send_ipi (victim, VEC_IPI_STL);
+    }
 }
 
 void Sc::rke_handler()
@@ -178,3 +357,170 @@ void Sc::rke_handler()
     if (Pd::current->Space_mem::htlb.chk (Cpu::id))
         Cpu::hazard |= HZD_SCHED;
 }
+
+bool Sc::update()
+{
+    mword u;
+    unsigned c, p, q;
+
+    {   Lock_guard <Spinlock> guard (lock);
+
+        // The EC can only follow once it left all IPC chains, a running EC
+        // is safe to move when schedule re-enqueues its own SC
+        bool stay = this == current ? ec->bound() : ec->pinned();
+
+        u = upd & static_cast<mword>(stay ? UPD_QPD : UPD_QPD | UPD_CPU);
+        upd &= ~u;
+
+        c = dst;
+        p = new_prio;
+        q = new_quantum;
+    }
+
+    if (u & UPD_QPD) {
+
+        prio   = base = p;
+        budget = Lapic::freq_tsc / 1000 * q;
+        left   = min (left, budget);
+
+        if (period) {
+            uint32 dummy;
+            util = static_cast<unsigned>(div64 (static_cast<uint64>(q) << 16, static_cast<uint32>(div64 (period, Lapic::freq_tsc / 1000, &dummy)), &dummy));
+        }
+
+        trace (TRACE_SCHEDULE, "UPD:%p PRIO:%#x", this, prio);
+    }
+
+    if (!(u & UPD_CPU) || c == cpu)
+        return false;
+
+    trace (TRACE_SCHEDULE, "MIG:%p CPU:%#x->%#x", this, cpu, c);
+
+    ec->migrate (c);
+    cpu = c;
+    remote_enqueue();
+
+    return true;
+}
+
+/*
+ * Wakeups may run in interrupt context, where migrating the EC must not
+ * allocate; pending updates are left to schedule.
+ */
+void Sc::defer_update()
+{
+    if (EXPECT_FALSE (upd)) {
+        rq.upd = 1;
+        Cpu::hazard |= HZD_SCHED;
+    }
+}
+
+Sc *Sc::update_candidate()
+{
+    for (unsigned w = priorities / prio_bits; w--; )
+        for (mword m = prio_map[w]; m; ) {
+
+            unsigned long b = bit_scan_reverse (m);
+            m &= ~(1UL << b);
+
+            Sc *h = list[w * prio_bits + b], *s = h;
+
+            do if (s->upd & UPD_QPD || (s->upd & UPD_CPU && !s->ec->pinned())) return s; while ((s = s->next) != h);
+        }
+
+    return nullptr;
+}
+
+void Sc::update_ready()
+{
+    // The current SC is updated when schedule re-enqueues it
+    if (current->upd)
+        Cpu::hazard |= HZD_SCHED;
+
+    for (Sc *sc; (sc = update_candidate()); ) {
+
+        uint64 t = rdtsc();
+
+        sc->ready_dequeue (t);
+
+        if (!sc->update())
+            sc->ready_enqueue (t);
+    }
+}
+
+void Sc::request()
+{
+    unsigned c = ACCESS_ONCE (cpu);
+
+    if (c == Cpu::id)
+        update_ready();
+
+    else {
+        Atomic::exchange (remote (c)->upd, 1U);
+        Lapic::send_ipi (c, VEC_IPI_STL);
+    }
+}
+
+void Sc::set_cpu (unsigned c)
+{
+    {   Lock_guard <Spinlock> guard (lock);
+
+        dst  = c;
+        upd |= UPD_CPU;
+    }
+
+    request();
+}
+
+void Sc::set_qpd (unsigned p, unsigned q)
+{
+    {   Lock_guard <Spinlock> guard (lock);
+
+        new_prio    = p;
+        new_quantum = q;
+        upd        |= UPD_QPD;
+    }
+
+    request();
+}
+
+void Sc::boost (unsigned p)
+{
+    if (p <= prio || cpu != Cpu::id)
+        return;
+
+    trace (TRACE_SCHEDULE, "INH:%p PRIO:%#x->%#x", this, prio, p);
+
+    if (!prev) {
+        prio = p;
+        return;
+    }
+
+    uint64 t = rdtsc();
+
+    ready_dequeue (t);
+    prio = p;
+    ready_enqueue (t);
+}
+
+void Sc::donate (Sc *s)
+{
+    uint64 t = rdtsc();
+
+    settle (t);
+
+    if (s && s != current) {
+        donee     = s;
+        donee_tsc = t;
+    }
+}
+
+void Sc::settle (uint64 t)
+{
+    if (!donee)
+        return;
+
+    current->time -= t - donee_tsc;
+    donee->time   += t - donee_tsc;
+    donee = nullptr;
+}
@@ -20,7 +20,9 @@
 
 #include "assert.hpp"
 #include "bits.hpp"
+#include "cpu.hpp"
 #include "lock_guard.hpp"
+#include "preempt_guard.hpp"
 #include "slab.hpp"
 #include "stdio.hpp"
 
@@ -57,9 +59,22 @@ void Slab::free (void *ptr)
     head = link;
 }
 
-Slab_cache::Slab_cache (unsigned long elem_size, unsigned elem_align)
+Slab_cache *Slab_cache::caches;
+
+INIT_PRIORITY (PRIO_SLAB)
+Slab_cache Slab_cache::mags (sizeof (Slab_mag), sizeof (mword), false);
+
+Slab_cache::Slab_cache (unsigned long elem_size, unsigned elem_align, bool m)
           : curr (nullptr),
             head (nullptr),
+            link (caches),
+            slabs (0),
+            empty (0),
+            loaded (),
+            previous (),
+            mag_full (nullptr),
+            mag_empty (nullptr),
+            mag (m),
             size (align_up (elem_size, sizeof (mword))),
             buff (align_up (size + sizeof (mword), elem_align)),
             elem ((PAGE_SIZE - sizeof (Slab)) / buff)
@@ -68,6 +83,8 @@ Slab_cache::Slab_cache (unsigned long elem_size, unsigned elem_align)
            this,
            elem_size,
            elem_align);
+
+    caches = this;
 }
 
 void Slab_cache::grow()
@@ -79,9 +96,181 @@ void Slab_cache::grow()
 
     slab->next = head;
     head = curr = slab;
+
+    slabs++;
+    empty++;
+}
+
+void Slab_cache::release (Slab *slab)
+{
+    if (slab == curr)
+        curr = slab->prev;
+
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        head = slab->next;
+
+    if (slab->next)
+        slab->next->prev = slab->prev;
+
+    delete slab;
+
+    slabs--;
+    empty--;
+}
+
+unsigned long Slab_cache::trim()
+{
+    unsigned long n = empty;
+
+    for (Slab *slab = head, *next; empty; slab = next) {
+
+        for (; !slab->empty(); slab = slab->next) ;
+
+        next = slab->next;
+        release (slab);
+    }
+
+    return n;
+}
+
+/*
+ * Called by the buddy allocator when it runs out of memory. Caches that
+ * are locked are skipped, which includes the one that is growing.
+ */
+unsigned long Slab_cache::shrink()
+{
+    unsigned long n = 0;
+    bool m = mags.lock.try_lock();
+
+    for (Slab_cache *c = caches; c; c = c->link) {
+
+        if (c == &mags || !c->lock.try_lock())
+            continue;
+
+        unsigned long s = c->slabs;
+
+        for (Slab_mag *g; (g = c->depot_get (c->mag_full)); ) {
+
+            while (g->avail)
+                c->slab_put (g->obj[--g->avail]);
+
+            if (m)
+                mags.slab_put (g);
+            else
+                c->depot_put (g);
+        }
+
+        for (Slab_mag *g; m && (g = c->depot_get (c->mag_empty)); )
+            mags.slab_put (g);
+
+        n += c->trim();
+
+        if (s != c->slabs)
+            trace (TRACE_MEMORY, "Slab Cache:%p slabs %lu -> %lu", c, s, c->slabs);
+
+        c->lock.unlock();
+    }
+
+    if (m) {
+        n += mags.trim();
+        mags.lock.unlock();
+    }
+
+    return n;
+}
+
+/*
+ * RCU callbacks free objects from the timer interrupt, so the caches are
+ * only touched with interrupts disabled. The per-CPU magazines need no
+ * lock and only the exchange with the depot is serialised.
+ */
+Slab_mag *Slab_cache::depot_get (Slab_mag *&list)
+{
+    Lock_guard <Spinlock> guard (depot);
+
+    Slab_mag *m = list;
+
+    if (m)
+        list = m->next;
+
+    return m;
+}
+
+void Slab_cache::depot_put (Slab_mag *m)
+{
+    Lock_guard <Spinlock> guard (depot);
+
+    Slab_mag *&list = m->avail ? mag_full : mag_empty;
+
+    m->next = list;
+    list = m;
 }
 
 void *Slab_cache::alloc()
+{
+    Preempt_guard preempt;
+
+    if (EXPECT_TRUE (mag && Cpu::is_ready())) {
+
+        Slab_mag *&l = loaded[Cpu::id], *&p = previous[Cpu::id], *m;
+
+        if (EXPECT_TRUE (l && l->avail))
+            return l->obj[--l->avail];
+
+        if (p && p->avail) {
+            m = l; l = p; p = m;
+            return l->obj[--l->avail];
+        }
+
+        if ((m = depot_get (mag_full))) {
+            if (p)
+                depot_put (p);
+            p = l; l = m;
+            return l->obj[--l->avail];
+        }
+    }
+
+    return slab_alloc();
+}
+
+void Slab_cache::free (void *ptr)
+{
+    Preempt_guard preempt;
+
+    if (EXPECT_TRUE (mag && Cpu::is_ready())) {
+
+        Slab_mag *&l = loaded[Cpu::id], *&p = previous[Cpu::id], *m;
+
+        if (EXPECT_TRUE (l && !l->full())) {
+            l->obj[l->avail++] = ptr;
+            return;
+        }
+
+        if (p && !p->full()) {
+            m = l; l = p; p = m;
+            l->obj[l->avail++] = ptr;
+            return;
+        }
+
+        if (!(m = depot_get (mag_empty))) {
+            m = static_cast<Slab_mag *>(mags.alloc());
+            m->avail = 0;
+        }
+
+        if (p)
+            depot_put (p);
+
+        p = l; l = m;
+        l->obj[l->avail++] = ptr;
+        return;
+    }
+
+    slab_free (ptr);
+}
+
+void *Slab_cache::slab_alloc()
 {
     Lock_guard <Spinlock> guard (lock);
 
@@ -91,6 +280,9 @@ void *Slab_cache::alloc()
     assert (!curr->full());
     assert (!curr->next || curr->next->full());
 
+    if (curr->empty())
+        empty--;
+
     // Allocate from slab
     void *ret = curr->alloc();
 
@@ -100,10 +292,15 @@ void *Slab_cache::alloc()
     return ret;
 }
 
-void Slab_cache::free (void *ptr)
+void Slab_cache::slab_free (void *ptr)
 {
     Lock_guard <Spinlock> guard (lock);
 
+    slab_put (ptr);
+}
+
+void Slab_cache::slab_put (void *ptr)
+{
     Slab *slab = reinterpret_cast<Slab *>(reinterpret_cast<mword>(ptr) & ~PAGE_MASK);
 
     bool was_full = slab->full();
@@ -157,4 +354,7 @@ void Slab_cache::free (void *ptr)
             head = head->prev = slab;
         }
     }
+
+    if (EXPECT_FALSE (slab->empty()) && ++empty > reserve)
+        release (slab);
 }
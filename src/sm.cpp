@@ -24,7 +24,41 @@
 INIT_PRIORITY (PRIO_SLAB)
 Slab_cache Sm::cache (sizeof (Sm), 32);
 
-Sm::Sm (Pd *own, mword sel, mword cnt) : Kobject (SM, static_cast<Space_obj *>(own), sel, 0x3), counter (cnt)
+Sm::Sm (Pd *own, mword sel, mword cnt, bool n) : Kobject (SM, static_cast<Space_obj *>(own), sel, 0x3), counter (cnt), word (nullptr), notify (n), gsi (0)
 {
-    trace (TRACE_SYSCALL, "SM:%p created (CNT:%lu)", this, cnt);
+    if (n)
+        trace (TRACE_SYSCALL, "SM:%p created (SIG:%#lx)", this, cnt);
+    else
+        trace (TRACE_SYSCALL, "SM:%p created (CNT:%lu)", this, cnt);
+}
+
+/*
+ * User semaphores keep count minus waiters in a word mapped at va.
+ * User code decrements and increments the word atomically and enters
+ * the kernel to block when the old value was not positive or to wake
+ * when it was negative.
+ */
+bool Sm::map (Pd *pd, mword va)
+{
+    if (EXPECT_FALSE (!va || va & PAGE_MASK || va >= USER_ADDR || !pd->Space_mem::insert_utcb (va)))
+        return false;
+
+    word = static_cast<mword *>(Buddy::allocator.alloc (0, Buddy::FILL_0));
+
+    *word = counter;
+    counter = 0;
+
+    pd->Space_mem::insert (va, 0, Hpt::HPT_U | Hpt::HPT_W | Hpt::HPT_P, Buddy::ptr_to_phys (word));
+
+    return true;
+}
+
+void Sm::unmap (Pd *pd, mword va)
+{
+    pd->Space_mem::remove_utcb (va);
+    pd->Space_mem::shootdown();
+
+    Buddy::allocator.free (reinterpret_cast<mword>(word));
+
+    word = nullptr;
 }
@@ -24,6 +24,7 @@
 #include "lapic.hpp"
 #include "mtrr.hpp"
 #include "pd.hpp"
+#include "rcu.hpp"
 #include "stdio.hpp"
 #include "svm.hpp"
 #include "vectors.hpp"
@@ -147,3 +148,22 @@ bool Space_mem::insert_utcb (mword b)
 
     return false;
 }
+
+void Space_mem::remove_utcb (mword b)
+{
+    if (!b)
+        return;
+
+    hpt.update (b, 0, 0, 0, Hpt::TYPE_DN);
+
+    for (unsigned i = 0; i < sizeof (loc) / sizeof (*loc); i++)
+        if (loc[i].addr())
+            loc[i].update (b, 0, 0, 0, Hpt::TYPE_DF);
+
+    htlb.merge (cpus);
+
+    Mdb *mdb = tree_lookup (b >> PAGE_BITS);
+
+    if (mdb && tree_remove (mdb))
+        Rcu::call (mdb);
+}
@@ -39,16 +39,16 @@ void Ec::sys_finish()
         current->clr_timeout();
 
     current->regs.set_status (S);
+
+    if (EXPECT_FALSE (current->mc_cnt))
+        multicall_next();
+
     ret_user_sysexit();
 }
 
 void Ec::activate()
 {
-    Ec *ec = this;
-
-    // XXX: Make the loop preemptible
-    for (Sc::ctr_link = 0; ec->partner; ec = ec->partner)
-        Sc::ctr_link++;
+    Ec *ec = (Sc::ctr_link = links()) ? root()->ctail : this;
 
     if (EXPECT_FALSE (ec->blocked()))
         ec->block_sc();
@@ -72,7 +72,8 @@ void Ec::delegate()
                          user ? dst->utcb->del : Crd (Crd::MEM, (dst->cont == ret_user_iret ? dst->regs.cr2 : dst->regs.nst_fault) >> PAGE_BITS),
                          src->utcb->xfer(),
                          user ? dst->utcb->xfer() : nullptr,
-                         src->utcb->ti());
+                         src->utcb->ti(),
+                         C ? &dst->tmp : nullptr);
 
     C ? ret_user_sysexit() : reply();
 }
@@ -109,6 +110,8 @@ void Ec::send_msg()
 
 void Ec::sys_call()
 {
+    uint64 t = rdtsc();
+
     Sys_call *s = static_cast<Sys_call *>(current->sys_regs());
 
     Kobject *obj = Space_obj::lookup (s->pt()).obj();
@@ -118,15 +121,32 @@ void Ec::sys_call()
     Pt *pt = static_cast<Pt *>(obj);
     Ec *ec = pt->ec;
 
-    if (EXPECT_FALSE (current->cpu != ec->xcpu))
+    if (EXPECT_FALSE (current->cpu != ec->xcpu)) {
+
+        if (s->flags() & Sys_call::CROSS_CPU && !ec->glb)
+            xcpu_call (pt);
+
         sys_finish<Sys_regs::BAD_CPU>();
+    }
 
     if (EXPECT_TRUE (!ec->cont)) {
+
+        // Simple messages are copied here so the callee returns straight to user
+        if (EXPECT_TRUE (!current->utcb->tcnt())) {
+            current->utcb->save (ec->utcb);
+            ec->cont = ret_user_sysexit;
+        } else
+            ec->cont = recv_user;
+
         current->cont = ret_user_sysexit;
         current->set_partner (ec);
-        ec->cont = recv_user;
         ec->regs.set_pt (pt->id);
         ec->regs.set_ip (pt->ip);
+
+        // Kernel cycles from entry until the switch to the callee
+        Counter::ipc_call++;
+        Counter::cycles_call += rdtsc() - t;
+
         ec->make_current();
     }
 
@@ -171,21 +191,69 @@ void Ec::reply (void (*c)())
 {
     current->cont = c;
 
+    if (EXPECT_FALSE (current->tmp.type()))
+        current->rev_tmp();
+
     if (EXPECT_FALSE (current->glb))
         Sc::schedule (true);
 
     Ec *ec = current->rcap;
 
-    if (EXPECT_FALSE (!ec || !ec->clr_partner()))
+    if (EXPECT_FALSE (!ec || !ec->clr_partner())) {
+        Sc::settle (rdtsc());
         Sc::current->ec->activate();
+    }
 
     ec->make_current();
 }
 
+void Ec::sys_forward()
+{
+    Sys_reply *s = static_cast<Sys_reply *>(current->sys_regs());
+
+    if (EXPECT_FALSE (!current->rcap || current->utcb->tcnt()))
+        sys_finish<Sys_regs::BAD_PAR>();
+
+    Kobject *obj = Space_obj::lookup (s->pt()).obj();
+    if (EXPECT_FALSE (obj->type() != Kobject::PT))
+        sys_finish<Sys_regs::BAD_CAP>();
+
+    Pt *pt = static_cast<Pt *>(obj);
+    Ec *ec = pt->ec;
+
+    if (EXPECT_FALSE (current->cpu != ec->xcpu))
+        sys_finish<Sys_regs::BAD_CPU>();
+
+    if (EXPECT_TRUE (!ec->cont)) {
+
+        if (EXPECT_FALSE (current->tmp.type()))
+            current->rev_tmp();
+
+        Counter::ipc_fwd++;
+        current->utcb->save (ec->utcb);
+        current->fwd_partner (ec);
+        current->cont = nullptr;
+        ec->cont = ret_user_sysexit;
+        ec->regs.set_pt (pt->id);
+        ec->regs.set_ip (pt->ip);
+        ec->make_current();
+    }
+
+    if (EXPECT_TRUE (!(s->flags() & Sys_reply::DISABLE_BLOCKING)))
+        ec->help (sys_reply);
+
+    sys_finish<Sys_regs::COM_TIM>();
+}
+
 void Ec::sys_reply()
 {
+    uint64 t = rdtsc();
+
     Ec *ec = current->rcap;
 
+    if (EXPECT_FALSE (current->sys_regs()->flags() & Sys_reply::FORWARD))
+        sys_forward();
+
     if (EXPECT_TRUE (ec)) {
 
         Utcb *src = current->utcb;
@@ -194,7 +262,10 @@ void Ec::sys_reply()
 
         if (EXPECT_TRUE (ec->cont == ret_user_sysexit))
             src->save (ec->utcb);
-        else if (ec->cont == ret_user_iret)
+        else if (ec->cont == xcpu_reply<Sys_regs::SUCCESS>) {
+            src->save (ec->utcb);
+            reply();
+        } else if (ec->cont == ret_user_iret)
             fpu = src->save_exc (&ec->regs);
         else if (ec->cont == ret_user_vmresume)
             fpu = src->save_vmx (&ec->regs);
@@ -206,6 +277,10 @@ void Ec::sys_reply()
 
         if (EXPECT_FALSE (src->tcnt()))
             delegate<false>();
+
+        // Kernel cycles from entry until the caller is resumed
+        Counter::ipc_reply++;
+        Counter::cycles_reply += rdtsc() - t;
     }
 
     reply();
@@ -279,7 +354,7 @@ void Ec::sys_create_sc()
 {
     Sys_create_sc *r = static_cast<Sys_create_sc *>(current->sys_regs());
 
-    trace (TRACE_SYSCALL, "EC:%p SYS_CREATE SC:%#lx EC:%#lx P:%#x Q:%#x", current, r->sel(), r->ec(), r->qpd().prio(), r->qpd().quantum());
+    trace (TRACE_SYSCALL, "EC:%p SYS_CREATE SC:%#lx EC:%#lx P:%#x Q:%#x F:%#x", current, r->sel(), r->ec(), r->qpd().prio(), r->qpd().quantum(), r->flags());
 
     Capability cap = Space_obj::lookup (r->pd());
     if (EXPECT_FALSE (cap.obj()->type() != Kobject::PD) || !(cap.prm() & 1UL << Kobject::SC)) {
@@ -304,7 +379,21 @@ void Ec::sys_create_sc()
         sys_finish<Sys_regs::BAD_PAR>();
     }
 
-    Sc *sc = new Sc (Pd::current, r->sel(), ec, ec->cpu, r->qpd().prio(), r->qpd().quantum());
+    bool mig = r->flags() & Sys_create_sc::MIGRATABLE;
+
+    if (EXPECT_FALSE (mig && !ec->utcb)) {
+        trace (TRACE_ERROR, "%s: Cannot migrate vCPU", __func__);
+        sys_finish<Sys_regs::BAD_PAR>();
+    }
+
+    bool edf = r->flags() & Sys_create_sc::DEADLINE;
+
+    if (EXPECT_FALSE (edf && (!r->dpd().period() || r->dpd().deadline() > r->dpd().period() || r->qpd().quantum() > r->dpd().deadline()))) {
+        trace (TRACE_ERROR, "%s: Invalid DPD", __func__);
+        sys_finish<Sys_regs::BAD_PAR>();
+    }
+
+    Sc *sc = new Sc (Pd::current, r->sel(), ec, ec->cpu, r->qpd().prio(), r->qpd().quantum(), mig, edf ? r->dpd().period() : 0, edf ? r->dpd().deadline() : 0);
     if (!Space_obj::insert_root (sc)) {
         trace (TRACE_ERROR, "%s: Non-NULL CAP (%#lx)", __func__, r->sel());
         delete sc;
@@ -362,9 +451,18 @@ void Ec::sys_create_sm()
         sys_finish<Sys_regs::BAD_CAP>();
     }
 
-    Sm *sm = new Sm (Pd::current, r->sel(), r->cnt());
+    Sm *sm = new Sm (Pd::current, r->sel(), r->cnt(), r->notify());
+
+    if (EXPECT_FALSE (r->user() && (r->notify() || !sm->map (Pd::current, r->va())))) {
+        trace (TRACE_ERROR, "%s: Bad VA (%#lx)", __func__, r->va());
+        delete sm;
+        sys_finish<Sys_regs::BAD_PAR>();
+    }
+
     if (!Space_obj::insert_root (sm)) {
         trace (TRACE_ERROR, "%s: Non-NULL CAP (%#lx)", __func__, r->sel());
+        if (sm->mapped())
+            sm->unmap (Pd::current, r->va());
         delete sm;
         sys_finish<Sys_regs::BAD_CAP>();
     }
@@ -426,13 +524,61 @@ void Ec::sys_sc_ctrl()
     Sys_sc_ctrl *r = static_cast<Sys_sc_ctrl *>(current->sys_regs());
 
     Capability cap = Space_obj::lookup (r->sc());
-    if (EXPECT_FALSE (cap.obj()->type() != Kobject::SC || !(cap.prm() & 1UL << 0))) {
+    if (EXPECT_FALSE (cap.obj()->type() != Kobject::SC || !(cap.prm() & 1UL << r->op()))) {
         trace (TRACE_ERROR, "%s: Bad SC CAP (%#lx)", __func__, r->sc());
         sys_finish<Sys_regs::BAD_CAP>();
     }
 
-    uint32 dummy;
-    r->set_time (div64 (static_cast<Sc *>(cap.obj())->time * 1000, Lapic::freq_tsc, &dummy));
+    Sc *sc = static_cast<Sc *>(cap.obj());
+
+    switch (r->op()) {
+
+        case 0:
+            uint32 dummy;
+            r->set_time (div64 (sc->time * 1000, Lapic::freq_tsc, &dummy));
+            break;
+
+        case 1:
+            if (EXPECT_FALSE (!Hip::cpu_online (r->cpu()))) {
+                trace (TRACE_ERROR, "%s: Invalid CPU (%#x)", __func__, r->cpu());
+                sys_finish<Sys_regs::BAD_CPU>();
+            }
+
+            if (EXPECT_FALSE (!sc->ec->utcb)) {
+                trace (TRACE_ERROR, "%s: Cannot migrate vCPU", __func__);
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
+
+            if (EXPECT_FALSE (sc->ec->scs > 1)) {
+                trace (TRACE_ERROR, "%s: Cannot migrate shared EC", __func__);
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
+
+            sc->set_cpu (r->cpu());
+            break;
+
+        case 2:
+            if (EXPECT_FALSE (!r->qpd().prio() || !r->qpd().quantum() || (sc->period && Lapic::freq_tsc / 1000 * r->qpd().quantum() > sc->deadline))) {
+                trace (TRACE_ERROR, "%s: Invalid QPD", __func__);
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
+
+            sc->set_qpd (r->qpd().prio(), r->qpd().quantum());
+            break;
+
+        case 3:
+            // The histograms would overwrite the multicall descriptors
+            if (EXPECT_FALSE (current->mc_cnt)) {
+                trace (TRACE_ERROR, "%s: Histograms in multicall", __func__);
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
+
+            for (unsigned i = 0; i < Sc::hist_buckets; i++) {
+                current->utcb->set_mr (i, sc->hist_wait[i]);
+                current->utcb->set_mr (i + Sc::hist_buckets, sc->hist_run[i]);
+            }
+            break;
+    }
 
     sys_finish<Sys_regs::SUCCESS>();
 }
@@ -466,16 +612,41 @@ void Ec::sys_sm_ctrl()
 
     Sm *sm = static_cast<Sm *>(cap.obj());
 
+    // The counter word of a user semaphore is only mapped in its own PD
+    if (EXPECT_FALSE (sm->mapped() && sm->space != static_cast<Space_obj *>(Pd::current))) {
+        trace (TRACE_ERROR, "%s: Foreign user SM (%#lx)", __func__, r->sm());
+        sys_finish<Sys_regs::BAD_CAP>();
+    }
+
     switch (r->op()) {
 
         case 0:
-            sm->up();
+            if (EXPECT_FALSE (sm->notify))
+                sm->signal (r->bits());
+            else
+                sm->up();
             break;
 
         case 1:
             if (sm->space == static_cast<Space_obj *>(&Pd::kern))
                 Gsi::unmask (static_cast<unsigned>(sm->node_base - NUM_CPU));
-            sm->dn (r->zc(), r->time());
+
+            if (EXPECT_FALSE (sm->notify)) {
+                current->clr_timeout();
+                mword bits = sm->collect (r->time(), r->slack());
+                if (EXPECT_FALSE (bits & sm->gsi))
+                    Gsi::unmask (sm, bits);
+                r->set_bits (bits);
+                break;
+            }
+
+            // Zeroing would break the count kept in the user word
+            if (EXPECT_FALSE (r->zc() && sm->mapped())) {
+                trace (TRACE_ERROR, "%s: Zero on user SM (%#lx)", __func__, r->sm());
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
+
+            sm->dn (r->zc(), r->time(), r->slack());
             break;
     }
 
@@ -531,17 +702,99 @@ void Ec::sys_assign_gsi()
         sys_finish<Sys_regs::BAD_CAP>();
     }
 
+    Sm *ntf = nullptr;
+
+    if (r->notify()) {
+        Capability cap = Space_obj::lookup (r->ntf());
+        if (EXPECT_FALSE (cap.obj()->type() != Kobject::SM || !static_cast<Sm *>(cap.obj())->notify || !(cap.prm() & 1UL << 0) || !r->bits())) {
+            trace (TRACE_ERROR, "%s: Bad NTF CAP (%#lx)", __func__, r->ntf());
+            sys_finish<Sys_regs::BAD_CAP>();
+        }
+        ntf = static_cast<Sm *>(cap.obj());
+    }
+
     Paddr phys; unsigned rid = 0, gsi = static_cast<unsigned>(sm->node_base - NUM_CPU);
     if (EXPECT_FALSE (!Gsi::gsi_table[gsi].ioapic && (!Pd::current->Space_mem::lookup (r->dev(), phys) || ((rid = Pci::phys_to_rid (phys)) == ~0U && (rid = Hpet::phys_to_rid (phys)) == ~0U)))) {
         trace (TRACE_ERROR, "%s: Non-DEV CAP (%#lx)", __func__, r->dev());
         sys_finish<Sys_regs::BAD_DEV>();
     }
 
+    Gsi::bind (gsi, ntf, r->bits());
+
     r->set_msi (Gsi::set (gsi, r->cpu(), rid));
 
     sys_finish<Sys_regs::SUCCESS>();
 }
 
+extern "C" void (*const syscall[])();
+
+void Ec::sys_multicall()
+{
+    Sys_multicall *r = static_cast<Sys_multicall *>(current->sys_regs());
+
+    current->mc_cnt = static_cast<unsigned>(current->utcb->ui() / Sys_multicall::words);
+    current->mc_idx = 0;
+    current->mc_flg = r->flags();
+
+    if (EXPECT_FALSE (!current->mc_cnt))
+        sys_finish<Sys_regs::BAD_PAR>();
+
+    multicall_next();
+}
+
+/*
+ * Each descriptor holds ARG_1..ARG_5 of one hypercall and receives the
+ * status and output arguments when that hypercall finishes
+ */
+void Ec::multicall_next()
+{
+    mword hzd = Cpu::hazard & (HZD_RCU | HZD_SCHED);
+    if (EXPECT_FALSE (hzd))
+        handle_hazard (hzd, multicall_next);
+
+    Ec *ec = current;
+    Utcb *u = ec->utcb;
+    Sys_regs *r = ec->sys_regs();
+    unsigned i = ec->mc_idx;
+
+    if (i) {
+        mword o = (i - 1) * Sys_multicall::words;
+
+        u->set_mr (o + 0, r->ARG_1);
+        u->set_mr (o + 1, r->ARG_2);
+        u->set_mr (o + 2, r->ARG_3);
+        u->set_mr (o + 3, r->ARG_4);
+        u->set_mr (o + 4, r->ARG_5);
+
+        if (EXPECT_FALSE (r->ARG_1 != Sys_regs::SUCCESS) && ec->mc_flg & Sys_multicall::STOP_ON_ERROR)
+            ec->mc_cnt = i;
+    }
+
+    if (EXPECT_FALSE (i == ec->mc_cnt)) {
+        ec->mc_cnt = 0;
+        r->ARG_2 = i;
+        r->set_status (Sys_regs::SUCCESS);
+        ret_user_sysexit();
+    }
+
+    mword o = i * Sys_multicall::words;
+
+    r->ARG_1 = u->get_mr (o + 0);
+    r->ARG_2 = u->get_mr (o + 1);
+    r->ARG_3 = u->get_mr (o + 2);
+    r->ARG_4 = u->get_mr (o + 3);
+    r->ARG_5 = u->get_mr (o + 4);
+
+    ec->mc_idx = i + 1;
+
+    // IPC switches ECs and cannot be batched
+    void (*f)() = syscall[r->ARG_1 & 0xf];
+    if (EXPECT_FALSE (f == sys_call || f == sys_reply || f == sys_multicall))
+        sys_finish<Sys_regs::BAD_HYP>();
+
+    asm volatile ("mov %0," EXPAND (PREG(sp);) "jmp *%1" : : "g" (CPU_LOCAL_STCK + PAGE_SIZE), "q" (f) : "memory"); UNREACHED;
+}
+
 extern "C"
 void (*const syscall[])() =
 {
@@ -560,7 +813,7 @@ void (*const syscall[])() =
     &Ec::sys_sm_ctrl,
     &Ec::sys_assign_pci,
     &Ec::sys_assign_gsi,
-    &Ec::sys_finish<Sys_regs::BAD_HYP>,
+    &Ec::sys_multicall,
 };
 
 template void Ec::sys_finish<Sys_regs::COM_ABT>();
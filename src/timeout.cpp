@@ -15,60 +15,139 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "counter.hpp"
 #include "lapic.hpp"
 #include "timeout.hpp"
 #include "x86.hpp"
 
-Timeout *Timeout::list;
+Timeout *Timeout::heap;
+uint64    Timeout::armed;
 
-void Timeout::enqueue (uint64 t)
+// Reprogram the LAPIC only when the effective deadline changes
+void Timeout::arm (uint64 t)
 {
-    time = t;
+    if (t == armed)
+        return;
+
+    armed = t;
+
+    Lapic::set_timer (t);
+
+    Counter::timer_set++;
+}
+
+void Timeout::disarm()
+{
+    armed = 0;
+
+    Lapic::clr_timer();
+}
+
+// Pairing heap: the first child links back to its parent, siblings link to each other
+Timeout *Timeout::meld (Timeout *a, Timeout *b)
+{
+    if (!a)
+        return b;
+
+    if (!b)
+        return a;
+
+    if (b->time < a->time) {
+        Timeout *t = a;
+        a = b;
+        b = t;
+    }
+
+    b->prev = a;
+    b->next = a->child;
+
+    if (a->child)
+        a->child->prev = b;
+
+    a->child = b;
+
+    return a;
+}
+
+Timeout *Timeout::merge_pairs (Timeout *h)
+{
+    Timeout *r = nullptr;
+
+    // Meld siblings pairwise from left to right, stacking the results
+    while (h) {
+
+        Timeout *a = h, *b = h->next;
 
-    Timeout *p = nullptr;
+        h = b ? b->next : nullptr;
 
-    for (Timeout *n = list; n; p = n, n = n->next)
-        if (n->time >= time)
-            break;
+        a->prev = a->next = nullptr;
 
-    prev = p;
+        if (b)
+            b->prev = b->next = nullptr;
 
-    if (!p) {
-        next = list;
-        list = this;
-        Lapic::set_timer (time);
-    } else {
-        next = p->next;
-        p->next = this;
+        a = meld (a, b);
+        a->next = r;
+        r = a;
     }
 
-    if (next)
-        next->prev = this;
+    // Meld the stacked pairs from right to left
+    for (h = nullptr; r; ) {
+        Timeout *n = r->next;
+        r->next = nullptr;
+        h = meld (h, r);
+        r = n;
+    }
+
+    return h;
+}
+
+void Timeout::enqueue (uint64 t)
+{
+    time = t;
+
+    prev = next = child = nullptr;
+
+    if ((heap = meld (heap, this)) == this)
+        arm (time);
 }
 
 uint64 Timeout::dequeue()
 {
     if (active()) {
 
-        if (next)
-            next->prev = prev;
+        Timeout *h = heap;
+
+        if (heap == this)
+            heap = merge_pairs (child);
 
-        if (prev)
-            prev->next = next;
+        else {
 
-        else if ((list = next))
-            Lapic::set_timer (list->time);
+            if (prev->child == this)
+                prev->child = next;
+            else
+                prev->next = next;
+
+            if (next)
+                next->prev = prev;
+
+            heap = meld (heap, merge_pairs (child));
+        }
+
+        if (heap && heap != h)
+            arm (heap->time);
     }
 
-    prev = next = nullptr;
+    prev = next = child = nullptr;
 
     return time;
 }
 
 void Timeout::check()
 {
-    while (list && list->time <= rdtsc()) {
-        Timeout *t = list;
+    armed = 0;
+
+    while (heap && heap->time <= rdtsc()) {
+        Timeout *t = heap;
         t->dequeue();
         t->trigger();
     }
@@ -0,0 +1,57 @@
+/*
+ * Hosted Build Environment
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "assert.hpp"
+#include "buddy.hpp"
+#include "counter.hpp"
+#include "cpu.hpp"
+#include "lapic.hpp"
+
+uint64      Host::tsc;
+uint64      Lapic::timer;
+unsigned    Lapic::writes;
+unsigned    Counter::timer_set;
+
+thread_local unsigned   Cpu::id;
+uint32                  Cpu::features[6];
+
+Buddy           Buddy::allocator;
+unsigned long   Buddy::pages;
+
+void *Buddy::alloc (unsigned short ord, Fill fill)
+{
+    size_t size = static_cast<size_t>(PAGE_SIZE) << ord;
+    void *p = aligned_alloc (PAGE_SIZE, size);
+
+    assert (p);
+
+    if (fill)
+        memset (p, fill == FILL_0 ? 0 : ~0, size);
+
+    __atomic_add_fetch (&pages, 1UL << ord, __ATOMIC_RELAXED);
+
+    return p;
+}
+
+// The tested code only frees single pages
+void Buddy::free (mword addr)
+{
+    ::free (reinterpret_cast<void *>(addr));
+
+    __atomic_sub_fetch (&pages, 1UL, __ATOMIC_RELAXED);
+}
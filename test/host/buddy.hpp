@@ -0,0 +1,40 @@
+/*
+ * Hosted Replacement: Buddy Allocator
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "compiler.hpp"
+#include "memory.hpp"
+#include "spinlock.hpp"
+
+// Page-aligned blocks from the host heap
+class Buddy
+{
+    public:
+        enum Fill
+        {
+            NOFILL,
+            FILL_0,
+            FILL_1
+        };
+
+        static Buddy allocator;
+
+        static unsigned long pages;
+
+        void *alloc (unsigned short ord, Fill fill = NOFILL);
+
+        void free (mword addr);
+};
@@ -0,0 +1,59 @@
+/*
+ * Hosted Replacement: Central Processing Unit (CPU)
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "compiler.hpp"
+#include "types.hpp"
+
+// Each thread of a test plays one CPU
+class Cpu
+{
+    public:
+        enum
+        {
+            EFL_IF = 1UL << 9,
+        };
+
+        enum Feature
+        {
+            FEAT_ERMS = 105,
+        };
+
+        static thread_local unsigned id;
+
+        static uint32 features[6];
+
+        ALWAYS_INLINE
+        static inline bool feature (Feature f)
+        {
+            return features[f / 32] & 1U << f % 32;
+        }
+
+        ALWAYS_INLINE
+        static inline void defeature (Feature f)
+        {
+            features[f / 32] &= ~(1U << f % 32);
+        }
+
+        ALWAYS_INLINE
+        static inline bool is_ready() { return true; }
+
+        ALWAYS_INLINE
+        static inline void preempt_disable() {}
+
+        ALWAYS_INLINE
+        static inline void preempt_enable() {}
+};
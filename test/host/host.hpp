@@ -0,0 +1,34 @@
+/*
+ * Hosted Build Environment
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "compiler.hpp"
+#include "types.hpp"
+
+/*
+ * The .cpulocal sections are not allocated in a hosted link. CPU-local
+ * variables become ordinary globals, so a test that runs several CPUs
+ * as threads keeps its per-CPU state in the replacement headers.
+ */
+#undef  CPULOCAL
+#undef  CPULOCAL_HOT
+#define CPULOCAL
+#define CPULOCAL_HOT
+
+namespace Host
+{
+    extern uint64 tsc;
+}
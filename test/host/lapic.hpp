@@ -0,0 +1,32 @@
+/*
+ * Hosted Replacement: Local APIC
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "compiler.hpp"
+#include "types.hpp"
+
+class Lapic
+{
+    public:
+        static uint64 timer;        // Programmed deadline, 0 if stopped
+        static unsigned writes;
+
+        ALWAYS_INLINE
+        static inline void set_timer (uint64 tsc) { timer = tsc; writes++; }
+
+        ALWAYS_INLINE
+        static inline void clr_timer() { timer = 0; writes++; }
+};
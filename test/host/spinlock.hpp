@@ -0,0 +1,55 @@
+/*
+ * Hosted Replacement: Spinlock
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <sched.h>
+
+#include "compiler.hpp"
+#include "types.hpp"
+
+/*
+ * Unlike a CPU with interrupts disabled, a thread can be preempted while
+ * it holds the lock. Waiters yield instead of spinning, so that tests do
+ * not convoy when there are more threads than host CPUs.
+ */
+class Spinlock
+{
+    private:
+        uint16 val;
+
+    public:
+        ALWAYS_INLINE
+        inline Spinlock() : val (0) {}
+
+        ALWAYS_INLINE
+        inline void lock()
+        {
+            while (!try_lock())
+                sched_yield();
+        }
+
+        ALWAYS_INLINE
+        inline bool try_lock()
+        {
+            return !__atomic_exchange_n (&val, 1, __ATOMIC_ACQUIRE);
+        }
+
+        ALWAYS_INLINE
+        inline void unlock()
+        {
+            __atomic_store_n (&val, 0, __ATOMIC_RELEASE);
+        }
+};
@@ -0,0 +1,32 @@
+/*
+ * Hosted Replacement: x86 Instructions
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "compiler.hpp"
+#include "types.hpp"
+
+ALWAYS_INLINE
+static inline void pause()
+{
+    asm volatile ("pause" : : : "memory");
+}
+
+// Time is driven by the test
+ALWAYS_INLINE
+static inline uint64 rdtsc()
+{
+    return Host::tsc;
+}
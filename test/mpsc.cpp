@@ -0,0 +1,145 @@
+/*
+ * Remote Run Queue Stress Test
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+#include "mpsc.hpp"
+
+#define CHECK(X)    do {                                                            \
+                        if (!(X)) {                                                 \
+                            std::printf ("FAIL %s:%d: %s\n", __FILE__, __LINE__, #X); \
+                            std::exit (1);                                          \
+                        }                                                           \
+                    } while (0)
+
+class Node
+{
+    public:
+        Node *next;
+        unsigned cpu;
+        unsigned seq;
+};
+
+static unsigned const cpus = 8;
+
+static Mpsc<Node> queue;
+
+// The consumer's pending IPI; several IPIs in flight collapse into one
+static unsigned irr;
+
+static unsigned done;
+static unsigned long kicks;
+
+/*
+ * Same protocol as Sc::remote_enqueue: only the producer that finds the
+ * queue empty sends an IPI
+ */
+static void producer (Node *n, unsigned cpu, unsigned ops)
+{
+    unsigned long k = 0;
+
+    for (unsigned i = 0; i < ops; i++) {
+
+        n[i].cpu = cpu;
+        n[i].seq = i;
+
+        if (queue.enqueue (n + i)) {
+            k++;
+            __atomic_store_n (&irr, 1, __ATOMIC_RELEASE);
+        }
+
+        // Let the consumer in, even on a host with a single CPU
+        if (i % 8 == cpu)
+            sched_yield();
+    }
+
+    __atomic_add_fetch (&kicks, k, __ATOMIC_RELAXED);
+    __atomic_add_fetch (&done, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Same protocol as Sc::rrq_handler: drain only when an IPI arrived. A
+ * queue that is left non-empty after all producers have finished and
+ * all IPIs have been taken is a lost wakeup.
+ */
+static void consumer (unsigned ops, unsigned long &drains)
+{
+    std::vector<unsigned> next (cpus);
+    unsigned long total = static_cast<unsigned long>(cpus) * ops, seen = 0;
+
+    while (seen < total) {
+
+        if (!__atomic_exchange_n (&irr, 0, __ATOMIC_ACQUIRE)) {
+            if (__atomic_load_n (&done, __ATOMIC_ACQUIRE) == cpus)
+                CHECK (__atomic_exchange_n (&irr, 0, __ATOMIC_ACQUIRE) || queue.empty());
+            else
+                sched_yield();
+            continue;
+        }
+
+        drains++;
+
+        for (Node *n = queue.dequeue_all(); n; n = n->next, seen++) {
+            CHECK (n->cpu < cpus);
+            CHECK (n->seq == next[n->cpu]++);      // Arrival order per producer
+        }
+    }
+
+    CHECK (queue.empty());
+}
+
+static void test (unsigned ops)
+{
+    std::vector<Node> n (static_cast<size_t>(cpus) * ops);
+    std::vector<std::thread> t;
+    unsigned long drains = 0;
+
+    done = 0;
+    kicks = 0;
+
+    auto s = std::chrono::steady_clock::now();
+
+    std::thread c (consumer, ops, std::ref (drains));
+
+    for (unsigned i = 0; i < cpus; i++)
+        t.emplace_back (producer, &n[static_cast<size_t>(i) * ops], i, ops);
+
+    for (std::thread &x : t)
+        x.join();
+
+    c.join();
+
+    auto e = std::chrono::steady_clock::now();
+
+    unsigned long total = static_cast<unsigned long>(cpus) * ops;
+
+    std::printf ("mpsc: %u CPUs x %u wakeups against one CPU OK\n", cpus, ops);
+    std::printf ("      %lu IPIs (%.1f%% coalesced), %lu drains, %.1f ns/wakeup\n",
+                 kicks, 100.0 * static_cast<double>(total - kicks) / static_cast<double>(total), drains,
+                 std::chrono::duration<double, std::nano>(e - s).count() / static_cast<double>(total));
+}
+
+int main()
+{
+    test (1000);
+    test (1000000);
+
+    return 0;
+}
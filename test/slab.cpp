@@ -0,0 +1,214 @@
+/*
+ * Slab Allocator Stress Test and Benchmark
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cpu.hpp"
+#include "slab.hpp"
+
+#define CHECK(X)    do {                                                            \
+                        if (!(X)) {                                                 \
+                            std::printf ("FAIL %s:%d: %s\n", __FILE__, __LINE__, #X); \
+                            std::exit (1);                                          \
+                        }                                                           \
+                    } while (0)
+
+class Object
+{
+    public:
+        unsigned busy;
+        unsigned owner;
+        mword data[6];
+};
+
+static unsigned const cpus  = 8;
+static unsigned const slots = 256;
+static unsigned const depth = 64;
+static unsigned const burst = 256;
+
+static Slab_cache cache (sizeof (Object), sizeof (mword));
+static Slab_cache plain (sizeof (Object), sizeof (mword), false);
+
+// Objects handed from one CPU to another, so that they are freed remotely
+static Object *slot[slots];
+
+static long outstanding;
+
+static Object *get (Slab_cache &c)
+{
+    Object *o = static_cast<Object *>(c.alloc());
+
+    // Nobody else may hold the object
+    CHECK (!__atomic_exchange_n (&o->busy, 1, __ATOMIC_ACQ_REL));
+
+    o->owner = Cpu::id;
+
+    for (mword &d : o->data)
+        d = reinterpret_cast<mword>(o);
+
+    __atomic_add_fetch (&outstanding, 1, __ATOMIC_RELAXED);
+
+    return o;
+}
+
+static void put (Slab_cache &c, Object *o)
+{
+    CHECK (o->owner == Cpu::id);
+
+    for (mword &d : o->data)
+        CHECK (d == reinterpret_cast<mword>(o));
+
+    __atomic_store_n (&o->busy, 0, __ATOMIC_RELEASE);
+
+    __atomic_sub_fetch (&outstanding, 1, __ATOMIC_RELAXED);
+
+    c.free (o);
+}
+
+static void stress (Slab_cache *c, unsigned cpu, unsigned ops)
+{
+    Cpu::id = cpu;
+
+    std::mt19937 rng (cpu);
+    Object *live[depth], *bulk[burst];
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < ops; i++) {
+
+        unsigned k = n ? rng() % n : 0;
+
+        switch (rng() % 8) {
+
+            case 0 ... 2:
+                if (n < depth)
+                    live[n++] = get (*c);
+                break;
+
+            case 3 ... 5:
+                if (n) {
+                    put (*c, live[k]);
+                    live[k] = live[--n];
+                }
+                break;
+
+            case 6:
+                if (n) {
+                    Object *o = __atomic_exchange_n (slot + rng() % slots, live[k], __ATOMIC_ACQ_REL);
+                    if (o) {
+                        o->owner = cpu;
+                        live[k] = o;
+                    } else
+                        live[k] = live[--n];
+                }
+                break;
+
+            case 7:
+                // Run through the depot and grow the magazine cache
+                if (rng() % 256)
+                    break;
+                for (Object *&o : bulk)
+                    o = get (*c);
+                for (Object *o : bulk)
+                    put (*c, o);
+                break;
+        }
+    }
+
+    while (n)
+        put (*c, live[--n]);
+}
+
+static void test (Slab_cache &c, char const *name, unsigned ops)
+{
+    std::vector<std::thread> t;
+
+    for (unsigned i = 0; i < cpus; i++)
+        t.emplace_back (stress, &c, i, ops);
+
+    for (std::thread &x : t)
+        x.join();
+
+    Cpu::id = 0;
+
+    for (Object *&o : slot)
+        if (o) {
+            o->owner = Cpu::id;
+            put (c, o);
+            o = nullptr;
+        }
+
+    CHECK (!outstanding);
+
+    unsigned long p = Buddy::pages;
+    unsigned long s = Slab_cache::shrink();
+
+    std::printf ("slab: %s, %u CPUs, %u operations each OK (pages %lu, %lu trimmed)\n", name, cpus, ops, p, s);
+}
+
+static void loop (Slab_cache *c, unsigned cpu, unsigned ops)
+{
+    Cpu::id = cpu;
+
+    void *o[8];
+
+    for (unsigned i = 0; i < ops; i += 8) {
+        for (void *&x : o)
+            x = c->alloc();
+        for (void *x : o)
+            c->free (x);
+    }
+}
+
+static double bench (Slab_cache &c, unsigned n, unsigned ops)
+{
+    std::vector<std::thread> t;
+
+    auto s = std::chrono::steady_clock::now();
+
+    for (unsigned i = 0; i < n; i++)
+        t.emplace_back (loop, &c, i, ops);
+
+    for (std::thread &x : t)
+        x.join();
+
+    auto e = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(e - s).count() / (static_cast<double>(ops) * n);
+}
+
+int main()
+{
+    test (cache, "magazines", 1000000);
+    test (plain, "slab only", 1000000);
+
+    unsigned ops = 4000000;
+
+    std::printf ("%4s %10s %16s %16s\n", "CPUs", "ops/CPU", "slab ns/op", "magazine ns/op");
+
+    for (unsigned n : { 1, 2, 4, 8 }) {
+        double s = bench (plain, n, ops);
+        double m = bench (cache, n, ops);
+        std::printf ("%4u %10u %16.1f %16.1f\n", n, ops, s, m);
+    }
+
+    std::printf ("(%u host CPUs)\n", std::thread::hardware_concurrency());
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Timeout Test and Benchmark
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "lapic.hpp"
+#include "timeout.hpp"
+
+#define CHECK(X)    do {                                                            \
+                        if (!(X)) {                                                 \
+                            std::printf ("FAIL %s:%d: %s\n", __FILE__, __LINE__, #X); \
+                            std::exit (1);                                          \
+                        }                                                           \
+                    } while (0)
+
+class Timeout_test : public Timeout
+{
+    public:
+        static std::vector<Timeout_test *> fired;
+
+        uint64 when() const { return time; }
+
+        void trigger() { fired.push_back (this); }
+};
+
+std::vector<Timeout_test *> Timeout_test::fired;
+
+/*
+ * The sorted list that the pairing heap replaced, kept as the baseline
+ * for the benchmark
+ */
+class Timeout_list
+{
+    private:
+        Timeout_list *prev, *next;
+        uint64 time;
+
+    public:
+        static Timeout_list *list;
+
+        Timeout_list() : prev (nullptr), next (nullptr), time (0) {}
+
+        bool active() const { return prev || list == this; }
+
+        void enqueue (uint64 t)
+        {
+            time = t;
+
+            Timeout_list *p = nullptr;
+
+            for (Timeout_list *n = list; n; p = n, n = n->next)
+                if (n->time >= time)
+                    break;
+
+            prev = p;
+
+            if (!p) {
+                next = list;
+                list = this;
+                Lapic::set_timer (time);
+            } else {
+                next = p->next;
+                p->next = this;
+            }
+
+            if (next)
+                next->prev = this;
+        }
+
+        uint64 dequeue()
+        {
+            if (active()) {
+
+                if (next)
+                    next->prev = prev;
+
+                if (prev)
+                    prev->next = next;
+
+                else if ((list = next))
+                    Lapic::set_timer (list->time);
+            }
+
+            prev = next = nullptr;
+
+            return time;
+        }
+};
+
+Timeout_list *Timeout_list::list;
+
+/*
+ * Random enqueue, arbitrary dequeue and expiry against an ordered
+ * multiset. After every step the earliest deadline and the programmed
+ * LAPIC deadline must match the reference.
+ */
+static void test (unsigned objs, unsigned ops, unsigned seed)
+{
+    std::mt19937_64 rng (seed);
+    std::vector<Timeout_test> t (objs);
+    std::multiset<std::pair<uint64, Timeout_test *>> ref;
+
+    Host::tsc = 0;
+
+    for (unsigned i = 0; i < ops; i++) {
+
+        Timeout_test *x = &t[rng() % objs];
+
+        switch (rng() % 8) {
+
+            case 0 ... 3:
+                if (x->active())
+                    break;
+                x->enqueue (Host::tsc + 1 + rng() % 1000);
+                ref.emplace (x->when(), x);
+                break;
+
+            case 4 ... 5:
+                if (x->active())
+                    ref.erase (ref.find (std::make_pair (x->when(), x)));
+                x->dequeue();
+                CHECK (!x->active());
+                break;
+
+            case 6:
+                Host::tsc += rng() % 100;
+                Timeout_test::fired.clear();
+                Timeout::check();
+                for (Timeout_test *f : Timeout_test::fired) {
+                    CHECK (!ref.empty() && ref.begin()->first == f->when());
+                    CHECK (f->when() <= Host::tsc && !f->active());
+                    ref.erase (ref.find (std::make_pair (f->when(), f)));
+                }
+                CHECK (ref.empty() || ref.begin()->first > Host::tsc);
+                break;
+
+            case 7:
+                // Re-arm a pending timeout, as Timeout_budget does
+                if (!x->active())
+                    break;
+                ref.erase (ref.find (std::make_pair (x->when(), x)));
+                x->dequeue();
+                x->enqueue (Host::tsc + 1 + rng() % 1000);
+                ref.emplace (x->when(), x);
+                break;
+        }
+
+        CHECK (Timeout::earliest() == (ref.empty() ? ~0ULL : ref.begin()->first));
+        CHECK (ref.empty() || Lapic::timer == ref.begin()->first);
+    }
+
+    for (Timeout_test &x : t)
+        x.dequeue();
+
+    CHECK (!Timeout::heap);
+
+    std::printf ("timeout: %u objects, %u operations OK\n", objs, ops);
+}
+
+template <typename T>
+static double bench (unsigned pending, unsigned ops)
+{
+    std::mt19937_64 rng (pending);
+    std::vector<T> t (pending + 1);
+    std::vector<uint64> d (pending);
+
+    for (uint64 &v : d)
+        v = rng() % (1ULL << 40);
+
+    // Latest deadline first, so that filling the list is not quadratic
+    std::sort (d.rbegin(), d.rend());
+
+    for (unsigned i = 0; i < pending; i++)
+        t[i].enqueue (d[i]);
+
+    T &x = t[pending];
+
+    auto s = std::chrono::steady_clock::now();
+
+    for (unsigned i = 0; i < ops; i++) {
+        x.enqueue (rng() % (1ULL << 40));
+        x.dequeue();
+    }
+
+    auto e = std::chrono::steady_clock::now();
+
+    for (T &y : t)
+        y.dequeue();
+
+    return std::chrono::duration<double, std::nano>(e - s).count() / ops;
+}
+
+int main()
+{
+    test (16, 1000000, 1);
+    test (1000, 1000000, 2);
+
+    std::printf ("%8s %8s %12s %12s\n", "pending", "ops", "list ns/op", "heap ns/op");
+
+    for (unsigned pending : { 10, 1000, 100000 }) {
+        unsigned ops = pending < 1000 ? 1000000 : 100000000 / pending;
+        double l = bench<Timeout_list> (pending, ops);
+        double h = bench<Timeout_test> (pending, ops);
+        std::printf ("%8u %8u %12.1f %12.1f\n", pending, ops, l, h);
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * UTCB Message Copy Benchmark
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include <chrono>
+#include <cpuid.h>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+
+#include "utcb.hpp"
+
+#define CHECK(X)    do {                                                            \
+                        if (!(X)) {                                                 \
+                            std::printf ("FAIL %s:%d: %s\n", __FILE__, __LINE__, #X); \
+                            std::exit (1);                                          \
+                        }                                                           \
+                    } while (0)
+
+class Utcb_test : public Utcb
+{
+    public:
+        void set_items (mword i) { items = i; }
+
+        // The word loop that Utcb::save replaced
+        NOINLINE
+        void save_loop (Utcb_test *dst)
+        {
+            mword n = ui();
+
+            dst->items = items;
+
+            for (unsigned long i = 0; i < n; i++)
+                dst->set_mr (i, get_mr (i));
+        }
+};
+
+static unsigned const erms = Cpu::FEAT_ERMS;
+
+static void set_erms (bool on)
+{
+    if (on)
+        Cpu::features[erms / 32] |= 1U << erms % 32;
+    else
+        Cpu::defeature (Cpu::FEAT_ERMS);
+}
+
+static void test (Utcb_test *s, Utcb_test *d)
+{
+    for (mword n = 0; n <= 1024; n++) {
+
+        s->set_items (n);
+
+        for (mword i = 0; i < s->ui(); i++) {
+            s->set_mr (i, ~i);
+            d->set_mr (i, 0);
+        }
+
+        s->save (d);
+
+        CHECK (d->ucnt() == n);
+
+        for (mword i = 0; i < s->ui(); i++)
+            CHECK (d->get_mr (i) == ~i);
+    }
+}
+
+template <bool LOOP>
+static double bench (Utcb_test *s, Utcb_test *d, mword n, unsigned ops)
+{
+    s->set_items (n);
+
+    auto t = std::chrono::steady_clock::now();
+
+    for (unsigned i = 0; i < ops; i++) {
+        if (LOOP)
+            s->save_loop (d);
+        else
+            s->save (d);
+        asm volatile ("" : : "r" (d) : "memory");
+    }
+
+    auto e = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(e - t).count() / ops;
+}
+
+int main()
+{
+    Utcb_test *s = static_cast<Utcb_test *>(new Utcb), *d = static_cast<Utcb_test *>(new Utcb);
+
+    unsigned eax, ebx = 0, ecx, edx;
+    bool host_erms = __get_cpuid_count (7, 0, &eax, &ebx, &ecx, &edx) && ebx & 1U << erms % 32;
+
+    for (bool on : { false, true }) {
+        set_erms (on);
+        test (s, d);
+        std::printf ("utcb: save with%s ERMS OK\n", on ? "" : "out");
+    }
+
+    std::printf ("%6s %6s %12s %12s %12s\n", "words", "copied", "loop ns", "movs ns", "movsb ns");
+
+    for (mword n : { 1UL, 8UL, 64UL, 1000UL }) {
+
+        unsigned ops = 10000000;
+
+        s->set_items (n);
+
+        double l = bench<true> (s, d, n, ops);
+
+        set_erms (false);
+        double m = bench<false> (s, d, n, ops);
+
+        set_erms (true);
+        double b = bench<false> (s, d, n, ops);
+
+        std::printf ("%6lu %6lu %12.2f %12.2f %12.2f\n", n, s->ui(), l, m, b);
+    }
+
+    std::printf ("(%s, host %s ERMS)\n", sizeof (mword) == 8 ? "x86_64" : "x86_32", host_erms ? "has" : "lacks");
+
+    delete s;
+    delete d;
+
+    return 0;
+}